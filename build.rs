@@ -9,6 +9,11 @@ use std::{
 };
 
 fn main() -> Result<(), Box<dyn Error>> {
+    // Host builds do not link against the C SDK
+    if env::var_os("CARGO_FEATURE_HOST").is_some() {
+        return Ok(());
+    }
+
     let bolos_sdk = "./nanos-secure-sdk".to_string();
 
     let output = Command::new("arm-none-eabi-gcc")
@@ -136,6 +141,13 @@ fn main() -> Result<(), Box<dyn Error>> {
         command.define(define, None);
     }
 
+    if env::var_os("CARGO_FEATURE_NVM_STATS").is_some() {
+        command.define("HAVE_NVM_STATS", None);
+    }
+    if env::var_os("CARGO_FEATURE_PROFILING").is_some() {
+        command.define("HAVE_PROFILING", None);
+    }
+
     command.compile("rust-app");
 
     // Copy this crate's linker script into the working directory of
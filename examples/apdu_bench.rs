@@ -0,0 +1,87 @@
+//! APDU benchmark application
+//!
+//! Answers the commands sent by `tools/apdu_bench.py`, which measures the
+//! round-trip latency of each workload across payload sizes:
+//!
+//! | INS  | Workload                                             |
+//! |------|------------------------------------------------------|
+//! | 0x01 | Echo: returns the command data                       |
+//! | 0x02 | Hash: returns the SHA-256 of the command data        |
+//! | 0x03 | Sign: returns the secp256k1 ECDSA signature (r \|\| s)  |
+//! |      | of the SHA-256 of the command data                   |
+//! | 0x04 | Info: returns the transport of the command and the   |
+//! |      | size of the APDU buffer                              |
+//!
+//! Build with `cargo build --release --example apdu_bench`.
+
+#![no_std]
+#![no_main]
+
+use nanos_sdk::bindings::G_io_app;
+use nanos_sdk::ecc::{make_bip32_path, PrivateKey, Secp256k1};
+use nanos_sdk::hash::{Hasher, Sha256};
+use nanos_sdk::io::{Comm, Event, Reply, StatusWords};
+
+nanos_sdk::set_panic!(nanos_sdk::exiting_panic);
+
+/// Large enough for extended APDUs of 1000 bytes of data.
+const APDU_BUFFER_SIZE: usize = 1024;
+
+/// Kept out of the stack, which is only 1 KiB and must also hold the
+/// contexts of the hash and signature workloads.
+static mut COMM: Comm<APDU_BUFFER_SIZE> = Comm::const_default();
+
+const SIGNING_PATH: [u32; 5] = make_bip32_path(b"m/44'/0'/0'/0/0");
+
+fn handle<const N: usize>(comm: &mut Comm<N>, ins: u8, key: &PrivateKey<Secp256k1>) -> Reply {
+    let data = match comm.get_data() {
+        Ok(data) => data,
+        Err(sw) => return sw.into(),
+    };
+    match ins {
+        0x01 => {
+            let len = data.len();
+            // The data is right after the header, move it to the front
+            let start = comm.rx - len;
+            comm.apdu_buffer.copy_within(start..comm.rx, 0);
+            comm.tx = len;
+        }
+        0x02 => match Sha256::hash(data) {
+            Ok(digest) => comm.append(&digest),
+            Err(e) => return e.into(),
+        },
+        0x03 => {
+            let digest = match Sha256::hash(data) {
+                Ok(digest) => digest,
+                Err(e) => return e.into(),
+            };
+            match key.ecdsa_sign(&digest) {
+                Ok((sig, _)) => comm.append(&sig),
+                Err(e) => return e.into(),
+            }
+        }
+        0x04 => {
+            let media = unsafe { G_io_app.apdu_media } as u8;
+            comm.append(&[media]);
+            comm.append(&(N as u16).to_be_bytes());
+        }
+        _ => return StatusWords::Unknown.into(),
+    }
+    StatusWords::Ok.into()
+}
+
+#[no_mangle]
+extern "C" fn sample_main() {
+    let comm = unsafe { &mut COMM };
+    // Derivation is not part of the measured workloads
+    let key = match PrivateKey::<Secp256k1>::derive(&SIGNING_PATH) {
+        Ok(key) => key,
+        Err(_) => nanos_sdk::exit_app(1),
+    };
+    loop {
+        if let Event::Command(ins) = comm.next_event::<u8>() {
+            let reply = handle(comm, ins, &key);
+            comm.reply(reply);
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+
+"""
+
+/*******************************************************************************
+*   Ledger Nano S - Secure firmware
+*   (c) 2021 Ledger
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+Generates the packed character width tables of the BAGL fonts, indexed by font
+id (C_bagl_font_widths), from the font definition files:
+
+    ./fontwidths.py $(sed -n 's/#include "\(.*\)"/lib_bagl\/src\/\1/p' lib_bagl/src/bagl_font_rom.inc) > src/bagl_font_widths.c
+
+Widths are packed on 4 bits, two characters per byte with the first one in the
+low nibble, when all the characters of the font are less than 16 pixels wide,
+else on 8 bits.
+"""
+
+import argparse
+import re
+import sys
+
+CHARACTERS = re.compile(r"bagl_font_character_t\s+characters(\w+)\s*\[\d*\]\s*=\s*\{(.*?)\};", re.S)
+CHARACTER = re.compile(r"\{\s*(\d+)\s*,")
+FONT = re.compile(r"bagl_font_t\s+font(\w+)\s*=\s*\{(.*?)\};", re.S)
+COMMENT = re.compile(r"/\*.*?\*/|//[^\n]*", re.S)
+
+HEADER = """/* Generated by fontwidths.py from the fonts of lib_bagl, do not edit */
+
+#include "bagl.h"
+
+#ifdef HAVE_BAGL
+"""
+
+
+def c_int(value):
+    value = value.strip()
+    if value.lower().startswith("0x"):
+        return int(value, 16)
+    if len(value) > 1 and value.startswith("0"):
+        return int(value, 8)
+    return int(value)
+
+
+def parse(path):
+    with open(path, encoding="latin1") as f:
+        content = f.read()
+    characters = {}
+    for name, body in CHARACTERS.findall(content):
+        characters[name] = [int(w) for w in CHARACTER.findall(body)]
+    fonts = []
+    for name, body in FONT.findall(content):
+        fields = [f.strip() for f in COMMENT.sub("", body).split(",")]
+        font_id, first_char, last_char = fields[0], c_int(fields[5]), c_int(fields[6])
+        widths = characters[fields[7].replace("characters", "", 1)]
+        # some fonts declare more characters than they define
+        widths = widths[: last_char - first_char + 1]
+        fonts.append((name, font_id, first_char, widths))
+    return fonts
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate the width tables of BAGL fonts.")
+    parser.add_argument("font_file", help="Font definition files (.inc)", nargs="+")
+    args = parser.parse_args()
+
+    fonts = []
+    for path in args.font_file:
+        fonts += parse(path)
+    if not fonts:
+        sys.exit("Error: no font found")
+
+    print(HEADER)
+    entries = []
+    for name, font_id, first_char, widths in fonts:
+        if max(widths) < 16:
+            bits = 4
+            packed = [
+                widths[i] | ((widths[i + 1] if i + 1 < len(widths) else 0) << 4)
+                for i in range(0, len(widths), 2)
+            ]
+        else:
+            bits = 8
+            packed = widths
+        print("static const unsigned char widths{0}[{1}] = {{".format(name, len(packed)))
+        for i in range(0, len(packed), 12):
+            print("  " + ", ".join("0x{0:02x}".format(b) for b in packed[i:i + 12]) + ",")
+        print("};\n")
+        entries.append(
+            "  [{0}] = {{ 0x{1:04x}, 0x{2:04x}, {3}, widths{4} }},".format(
+                font_id, first_char, first_char + len(widths) - 1, bits, name
+            )
+        )
+
+    print("const bagl_font_widths_t C_bagl_font_widths[BAGL_FONT_LAST] = {")
+    print("\n".join(entries))
+    print("};\n")
+    print("#endif // HAVE_BAGL")
+
+
+if __name__ == "__main__":
+    main()
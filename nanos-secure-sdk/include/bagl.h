@@ -179,6 +179,21 @@ typedef enum {
   BAGL_FONT_LAST // MUST ALWAYS BE THE LAST, FOR AUTOMATED INVALID VALUE CHECKS
 } bagl_font_id_e;
 
+// embedded fonts indexed by font id, NULL when not embedded
+extern const bagl_font_t *const C_bagl_fonts_by_id[BAGL_FONT_LAST];
+
+// character widths of a font, generated by fontwidths.py for every font of
+// lib_bagl, available even when the font itself is not embedded
+typedef struct {
+  unsigned short first_char;
+  unsigned short last_char;
+  unsigned char bits_per_width; // 4: two widths per byte, low nibble first, or 8
+  const unsigned char *widths;
+} bagl_font_widths_t;
+
+// indexed by font id, widths is NULL for unknown fonts
+extern const bagl_font_widths_t C_bagl_font_widths[BAGL_FONT_LAST];
+
 #define BAGL_FONT_SYMBOLS_0_CLEAR "\x80"
 #define BAGL_FONT_SYMBOLS_0_DOT "\x81"
 #define BAGL_FONT_SYMBOLS_0_LEFT "\x82"
@@ -253,6 +268,24 @@ unsigned short bagl_compute_line_width(unsigned short font_id,
                                        unsigned short width, const void *text,
                                        unsigned char text_length,
                                        unsigned char text_encoding);
+
+// metrics of the first line of a text, computed in a single pass
+typedef struct {
+  unsigned short width;  // width in pixels of the measured characters
+  unsigned short length; // number of measured characters, up to the maximum
+                         // width or to the first line break (excluded)
+  unsigned short glyph_count; // number of measured characters having a glyph
+  unsigned short last_delim;  // index of the last measured word delimiter
+                              // (space, tab, '-' or '_'), 0 if none
+  unsigned short last_delim_width; // width of the characters before it
+  unsigned char line_break; // the line ends with '\n' or '\r'
+} bagl_text_metrics_t;
+
+// measure the first line of a text, up to width pixels if not 0
+void bagl_compute_text_metrics(unsigned short font_id, unsigned short width,
+                               const void *text, unsigned short text_length,
+                               unsigned char text_encoding,
+                               bagl_text_metrics_t *metrics);
 int bagl_draw_string(unsigned short font_id, unsigned int color1,
                      unsigned int color0, int x, int y, unsigned int width,
                      unsigned int height, const void *text,
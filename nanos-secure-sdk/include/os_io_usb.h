@@ -39,8 +39,24 @@ typedef enum io_usb_hid_receive_status_e {
 
 extern volatile unsigned int G_io_usb_hid_total_length;
 
+/**
+ * Callback fed with each chunk of a command APDU, as soon as it has been
+ * copied out of the HID endpoint buffer. offset is the position of the chunk
+ * in the APDU.
+ */
+typedef void (*io_usb_hid_chunk_callback_t)(void *ctx,
+                                            const unsigned char *chunk,
+                                            unsigned short length,
+                                            unsigned int offset);
+
 void io_usb_hid_init(void);
 
+/**
+ * Register (or unregister with NULL) the callback notified of each received
+ * command APDU chunk.
+ */
+void io_usb_hid_set_chunk_callback(io_usb_hid_chunk_callback_t callback, void *ctx);
+
 /**
  * Receive next HID transport packet, returns IO_USB_APDU_RECEIVED when a
  * complete APDU has been received in the G_io_apdu_buffer To be called
@@ -110,6 +110,11 @@ void bagl_draw_bg(unsigned int color) {
 const bagl_glyph_array_entry_t* bagl_get_glyph(unsigned int icon_id, const bagl_glyph_array_entry_t* glyph_array, unsigned int glyph_count) {
   unsigned int i=glyph_count; 
 
+  // dense array, the entry is at the index of its id (as in C_glyph_array)
+  if (icon_id < glyph_count && glyph_array[icon_id].icon_id == icon_id) {
+    return &glyph_array[icon_id];
+  }
+
   while(i--) {
     // font id match this entry (non linear)
     if (glyph_array[i].icon_id == icon_id) {
@@ -125,83 +130,28 @@ const bagl_glyph_array_entry_t* bagl_get_glyph(unsigned int icon_id, const bagl_
 // --------------------------------------------------------------------------------------
 // internal helper, get the font entry from the font id (sparse font array support)
 const bagl_font_t* bagl_get_font(unsigned int font_id) {
-  unsigned int i=C_bagl_fonts_count; 
   font_id &= BAGL_FONT_ID_MASK;
 
-  while(i--) {
-    // font id match this entry (non indexed array)
-    if (PIC_FONT(C_bagl_fonts[i])->font_id == font_id) {
-      return PIC_FONT(C_bagl_fonts[i]);
-    }
+  // id not found, or font not embedded
+  if (font_id >= BAGL_FONT_LAST || C_bagl_fonts_by_id[font_id] == NULL) {
+    return NULL;
   }
 
-  // id not found
-  return NULL;
+  // dense index by font id, only the returned entry is translated
+  return PIC_FONT(C_bagl_fonts_by_id[font_id]);
 }
 
 // --------------------------------------------------------------------------------------
 // return the width of a text (first line only) for alignment processing
 unsigned short bagl_compute_line_width(unsigned short font_id, unsigned short width, const void * text, unsigned char text_length, unsigned char text_encoding) {
-  unsigned short xx;
-  const bagl_font_t *font = bagl_get_font(font_id);
-  if (font == NULL) {
+  bagl_text_metrics_t metrics;
+  if (bagl_get_font(font_id) == NULL) {
     return 0;
   }
 
-  // initialize first index
-  xx = 0;
-
-  //printf("display text: %s\n", text);
-
-  // depending on encoding
-  while (text_length--) {
-    unsigned int ch = 0;
-    // TODO support other encoding than ascii ISO8859 Latin
-    switch(text_encoding) {
-      default:
-      case BAGL_ENCODING_LATIN1:
-        ch = *((unsigned char*)text);
-        text = (void*)(((unsigned char*)text)+1);
-        break;
-    }
-
-    unsigned char ch_width = 0; 
-    if (ch < font->first_char || ch > font->last_char) {
-      // only proceed the first line width, not the whole paragraph
-      if (ch == '\n' || ch == '\r') {
-        return xx;
-      }
-
-      // else use the low bits as an extra spacing value
-      if (ch >= 0xC0) {
-        ch_width = ch&0x3F;
-      }
-      else if (ch >= 0x80) {
-        // open the glyph font
-        const bagl_font_t *font_symbols = bagl_get_font((ch&0x20)?BAGL_FONT_SYMBOLS_1:BAGL_FONT_SYMBOLS_0);
-        if (font_symbols != NULL) {
-          // extract the size of the symbols' font character
-          ch_width = PIC_CHAR(font_symbols->characters)[ch & 0x1F].char_width;
-        }
-      }
-    }
-    else {
-      // compute the index in the bitmap array
-      ch -= font->first_char;
-      ch_width = PIC_CHAR(font->characters)[ch].char_width;
-    }
-
-    // retrieve the char bitmap
-
-    // go to next line if needed, kerning is not used here
-    if (width > 0 && xx + ch_width > width) {
-      return xx;
-    }
-
-    // prepare for next char
-    xx += ch_width;
-  }
-  return xx;
+  // widths are read from the packed tables of the fonts
+  bagl_compute_text_metrics(font_id, width, text, text_length, text_encoding, &metrics);
+  return metrics.width;
 }
 
 // --------------------------------------------------------------------------------------
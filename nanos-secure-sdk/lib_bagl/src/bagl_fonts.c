@@ -40,12 +40,22 @@ const bagl_font_t fontNONE = {
    NULL   /* bitmap address*/
 };
 
+#define BAGL_FONT_ENTRY(id, font) &font,
 const bagl_font_t* const C_bagl_fonts[] = {
 
 #include "bagl_font_rom_struct.inc"
 
 
 };
+#undef BAGL_FONT_ENTRY
 
 const unsigned int C_bagl_fonts_count = sizeof(C_bagl_fonts)/sizeof(C_bagl_fonts[0]);
 
+// Dense index from font id to font, NULL for the fonts which are not embedded
+#define BAGL_FONT_ENTRY(id, font) [id] = &font,
+const bagl_font_t* const C_bagl_fonts_by_id[BAGL_FONT_LAST] = {
+
+#include "bagl_font_rom_struct.inc"
+
+};
+#undef BAGL_FONT_ENTRY
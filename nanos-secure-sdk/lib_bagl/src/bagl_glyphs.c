@@ -2259,211 +2259,213 @@ unsigned char const C_app_firmware_bitmap[] = {
 
 #define BAGL_GLYPH_NONE { -1UL, 0, 0, 0, NULL, NULL}
 
+// Entries are placed at the index of their icon id, for bagl_get_glyph to
+// find them directly. The ids of the glyphs which are not embedded are holes.
 const bagl_glyph_array_entry_t const C_glyph_array[] = {
-  BAGL_GLYPH_NONE, // icon_id = 0
+  [BAGL_GLYPH_NOGLYPH] = BAGL_GLYPH_NONE, // icon_id = 0
 
 #ifdef HAVE_BAGL_GLYPH_LOGO_LEDGER_100
-  {BAGL_GLYPH_LOGO_LEDGER_100, 101, 104, 4, C_logo_ledger_colors, C_logo_ledger_bitmap},
+  [BAGL_GLYPH_LOGO_LEDGER_100] = {BAGL_GLYPH_LOGO_LEDGER_100, 101, 104, 4, C_logo_ledger_colors, C_logo_ledger_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_LOGO_LEDGER_BLUE_120
-  {BAGL_GLYPH_LOGO_LEDGER_BLUE_120, 120, 72, 4, C_logo_ledger_blue_colors, C_logo_ledger_blue_bitmap},
+  [BAGL_GLYPH_LOGO_LEDGER_BLUE_120] = {BAGL_GLYPH_LOGO_LEDGER_BLUE_120, 120, 72, 4, C_logo_ledger_blue_colors, C_logo_ledger_blue_bitmap},
 #endif 
 
 #ifdef HAVE_BAGL_GLYPH_ICON_GEARS_50
-  {BAGL_GLYPH_ICON_GEARS_50, 50, 50, 2, C_icon_bootloader_colors, C_icon_bootloader_bitmap},
+  [BAGL_GLYPH_ICON_GEARS_50] = {BAGL_GLYPH_ICON_GEARS_50, 50, 50, 2, C_icon_bootloader_colors, C_icon_bootloader_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_CLEAR_16
-  {BAGL_GLYPH_ICON_CLEAR_16, 16, 16, 2, C_icon_clear_colors, C_icon_clear_bitmap},
+  [BAGL_GLYPH_ICON_CLEAR_16] = {BAGL_GLYPH_ICON_CLEAR_16, 16, 16, 2, C_icon_clear_colors, C_icon_clear_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_BACKSPACE_20
-  {BAGL_GLYPH_ICON_BACKSPACE_20, 20, 14, 2, C_icon_backspace_colors, C_icon_backspace_bitmap},
+  [BAGL_GLYPH_ICON_BACKSPACE_20] = {BAGL_GLYPH_ICON_BACKSPACE_20, 20, 14, 2, C_icon_backspace_colors, C_icon_backspace_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_CHECK
-  {BAGL_GLYPH_ICON_CHECK, 8, 6, 1, C_icon_check_colors, C_icon_check_bitmap},
+  [BAGL_GLYPH_ICON_CHECK] = {BAGL_GLYPH_ICON_CHECK, 8, 6, 1, C_icon_check_colors, C_icon_check_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_CROSS
-  {BAGL_GLYPH_ICON_CROSS, 7, 7, 1, C_icon_cross_colors, C_icon_cross_bitmap},
+  [BAGL_GLYPH_ICON_CROSS] = {BAGL_GLYPH_ICON_CROSS, 7, 7, 1, C_icon_cross_colors, C_icon_cross_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_CHECK_BADGE
-  {BAGL_GLYPH_ICON_CHECK_BADGE, 14, 14, 1, C_badge_validate_colors, C_badge_validate_bitmap},
+  [BAGL_GLYPH_ICON_CHECK_BADGE] = {BAGL_GLYPH_ICON_CHECK_BADGE, 14, 14, 1, C_badge_validate_colors, C_badge_validate_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_LEFT
-  {BAGL_GLYPH_ICON_LEFT, 4, 7, 1, C_icon_left_colors, C_icon_left_bitmap},
+  [BAGL_GLYPH_ICON_LEFT] = {BAGL_GLYPH_ICON_LEFT, 4, 7, 1, C_icon_left_colors, C_icon_left_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_RIGHT
-  {BAGL_GLYPH_ICON_RIGHT, 4, 7, 1, C_icon_right_colors, C_icon_right_bitmap},
+  [BAGL_GLYPH_ICON_RIGHT] = {BAGL_GLYPH_ICON_RIGHT, 4, 7, 1, C_icon_right_colors, C_icon_right_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_UP
-  {BAGL_GLYPH_ICON_UP, 7, 4, 1, C_icon_up_colors, C_icon_up_bitmap},
+  [BAGL_GLYPH_ICON_UP] = {BAGL_GLYPH_ICON_UP, 7, 4, 1, C_icon_up_colors, C_icon_up_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_DOWN
-  {BAGL_GLYPH_ICON_DOWN, 7, 4, 1, C_icon_down_colors, C_icon_down_bitmap},
+  [BAGL_GLYPH_ICON_DOWN] = {BAGL_GLYPH_ICON_DOWN, 7, 4, 1, C_icon_down_colors, C_icon_down_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_LOGO_LEDGER_MINI
-  {BAGL_GLYPH_LOGO_LEDGER_MINI, 16, 16, 1, C_logo_ledger_mini_colors, C_logo_ledger_mini_bitmap},
+  [BAGL_GLYPH_LOGO_LEDGER_MINI] = {BAGL_GLYPH_LOGO_LEDGER_MINI, 16, 16, 1, C_logo_ledger_mini_colors, C_logo_ledger_mini_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_CROSS_BADGE
-  {BAGL_GLYPH_ICON_CROSS_BADGE, 14, 14, 1, C_icon_cross_badge_colors, C_icon_cross_badge_bitmap},
+  [BAGL_GLYPH_ICON_CROSS_BADGE] = {BAGL_GLYPH_ICON_CROSS_BADGE, 14, 14, 1, C_icon_cross_badge_colors, C_icon_cross_badge_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_DASHBOARD_BADGE
-  {BAGL_GLYPH_ICON_DASHBOARD_BADGE, 14, 14, 1, C_badge_dashboard_colors, C_badge_dashboard_bitmap},
+  [BAGL_GLYPH_ICON_DASHBOARD_BADGE] = {BAGL_GLYPH_ICON_DASHBOARD_BADGE, 14, 14, 1, C_badge_dashboard_colors, C_badge_dashboard_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_PLUS
-  {BAGL_GLYPH_ICON_PLUS, 7, 7, 1, C_icon_plus_colors, C_icon_plus_bitmap},
+  [BAGL_GLYPH_ICON_PLUS] = {BAGL_GLYPH_ICON_PLUS, 7, 7, 1, C_icon_plus_colors, C_icon_plus_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_LESS
-  {BAGL_GLYPH_ICON_LESS, 6, 1, 1, C_icon_less_colors, C_icon_less_bitmap},
+  [BAGL_GLYPH_ICON_LESS] = {BAGL_GLYPH_ICON_LESS, 6, 1, 1, C_icon_less_colors, C_icon_less_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_TOGGLE_ON
-  {BAGL_GLYPH_ICON_TOGGLE_ON, 16, 10, 1, C_toggle_on_colors, C_toggle_on_bitmap},
+  [BAGL_GLYPH_ICON_TOGGLE_ON] = {BAGL_GLYPH_ICON_TOGGLE_ON, 16, 10, 1, C_toggle_on_colors, C_toggle_on_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_TOGGLE_OFF
-  {BAGL_GLYPH_ICON_TOGGLE_OFF, 16, 10, 1, C_toggle_off_colors, C_toggle_off_bitmap},
+  [BAGL_GLYPH_ICON_TOGGLE_OFF] = {BAGL_GLYPH_ICON_TOGGLE_OFF, 16, 10, 1, C_toggle_off_colors, C_toggle_off_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_LOADING_BADGE
-  {BAGL_GLYPH_ICON_LOADING_BADGE, 14, 14, 1, C_badge_loading_colors, C_badge_loading_bitmap},
+  [BAGL_GLYPH_ICON_LOADING_BADGE] = {BAGL_GLYPH_ICON_LOADING_BADGE, 14, 14, 1, C_badge_loading_colors, C_badge_loading_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_COG_BADGE
-  {BAGL_GLYPH_ICON_COG_BADGE, 16, 16, 1, C_app_settings_colors, C_app_settings_bitmap},
+  [BAGL_GLYPH_ICON_COG_BADGE] = {BAGL_GLYPH_ICON_COG_BADGE, 16, 16, 1, C_app_settings_colors, C_app_settings_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_WARNING_BADGE
-  {BAGL_GLYPH_ICON_WARNING_BADGE, 14, 14, 1, C_badge_warning_colors, C_badge_warning_bitmap},
+  [BAGL_GLYPH_ICON_WARNING_BADGE] = {BAGL_GLYPH_ICON_WARNING_BADGE, 14, 14, 1, C_badge_warning_colors, C_badge_warning_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_DOWNLOAD_BADGE
-  {BAGL_GLYPH_ICON_DOWNLOAD_BADGE, 14, 14, 1, C_badge_install_colors, C_badge_install_bitmap},
+  [BAGL_GLYPH_ICON_DOWNLOAD_BADGE] = {BAGL_GLYPH_ICON_DOWNLOAD_BADGE, 14, 14, 1, C_badge_install_colors, C_badge_install_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_TRANSACTION_BADGE
-  {BAGL_GLYPH_ICON_TRANSACTION_BADGE, 14, 14, 1, C_badge_transaction_colors, C_badge_transaction_bitmap},
+  [BAGL_GLYPH_ICON_TRANSACTION_BADGE] = {BAGL_GLYPH_ICON_TRANSACTION_BADGE, 14, 14, 1, C_badge_transaction_colors, C_badge_transaction_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_BITCOIN_BADGE
-  {BAGL_GLYPH_ICON_BITCOIN_BADGE, 14, 14, 1, C_badge_bitcoin_colors, C_badge_bitcoin_bitmap},
+  [BAGL_GLYPH_ICON_BITCOIN_BADGE] = {BAGL_GLYPH_ICON_BITCOIN_BADGE, 14, 14, 1, C_badge_bitcoin_colors, C_badge_bitcoin_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_ETHEREUM_BADGE
-  {BAGL_GLYPH_ICON_ETHEREUM_BADGE, 14, 14, 1, C_badge_ethereum_colors, C_badge_ethereum_bitmap},
+  [BAGL_GLYPH_ICON_ETHEREUM_BADGE] = {BAGL_GLYPH_ICON_ETHEREUM_BADGE, 14, 14, 1, C_badge_ethereum_colors, C_badge_ethereum_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_EYE_BADGE
-  {BAGL_GLYPH_ICON_EYE_BADGE, 14, 14, 1, C_badge_eye_colors, C_badge_eye_bitmap},
+  [BAGL_GLYPH_ICON_EYE_BADGE] = {BAGL_GLYPH_ICON_EYE_BADGE, 14, 14, 1, C_badge_eye_colors, C_badge_eye_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_PEOPLE_BADGE
-  {BAGL_GLYPH_ICON_PEOPLE_BADGE, 14, 14, 1, C_badge_people_colors, C_badge_people_bitmap},
+  [BAGL_GLYPH_ICON_PEOPLE_BADGE] = {BAGL_GLYPH_ICON_PEOPLE_BADGE, 14, 14, 1, C_badge_people_colors, C_badge_people_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_LOCK_BADGE
-  {BAGL_GLYPH_ICON_LOCK_BADGE, 14, 14, 1, C_badge_lock_colors, C_badge_lock_bitmap},
+  [BAGL_GLYPH_ICON_LOCK_BADGE] = {BAGL_GLYPH_ICON_LOCK_BADGE, 14, 14, 1, C_badge_lock_colors, C_badge_lock_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_BLUE_CABLE
-  {BAGL_GLYPH_ICON_BLUE_CABLE, 65, 62, 2, C_icon_blue_cable_colors, C_icon_blue_cable_bitmap},
+  [BAGL_GLYPH_ICON_BLUE_CABLE] = {BAGL_GLYPH_ICON_BLUE_CABLE, 65, 62, 2, C_icon_blue_cable_colors, C_icon_blue_cable_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_TEXT_WELCOME
-  {BAGL_GLYPH_TEXT_WELCOME, 113, 24, 4, C_text_welcome_colors, C_text_welcome_bitmap},
+  [BAGL_GLYPH_TEXT_WELCOME] = {BAGL_GLYPH_TEXT_WELCOME, 113, 24, 4, C_text_welcome_colors, C_text_welcome_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_LOGO_LEDGER_BOOT
-  {BAGL_GLYPH_LOGO_LEDGER_BOOT, 50, 50, 4, C_logo_ledger_boot_colors, C_logo_ledger_boot_bitmap},
+  [BAGL_GLYPH_LOGO_LEDGER_BOOT] = {BAGL_GLYPH_LOGO_LEDGER_BOOT, 50, 50, 4, C_logo_ledger_boot_colors, C_logo_ledger_boot_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_BATT_LEFT
-  {BAGL_GLYPH_BATT_LEFT, 4, 40, 2, C_icon_battery_left_colors, C_icon_battery_left_bitmap},
+  [BAGL_GLYPH_BATT_LEFT] = {BAGL_GLYPH_BATT_LEFT, 4, 40, 2, C_icon_battery_left_colors, C_icon_battery_left_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_BATT_RIGHT
-  {BAGL_GLYPH_BATT_RIGHT, 4, 40, 2, C_icon_battery_right_colors, C_icon_battery_right_bitmap},
+  [BAGL_GLYPH_BATT_RIGHT] = {BAGL_GLYPH_BATT_RIGHT, 4, 40, 2, C_icon_battery_right_colors, C_icon_battery_right_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_LIGHTNING
-  {BAGL_GLYPH_ICON_LIGHTNING, 17, 24, 4, C_icon_lightning_colors, C_icon_lightning_bitmap},
+  [BAGL_GLYPH_ICON_LIGHTNING] = {BAGL_GLYPH_ICON_LIGHTNING, 17, 24, 4, C_icon_lightning_colors, C_icon_lightning_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_ICON_PLUG
-  {BAGL_GLYPH_ICON_PLUG, 24, 15, 4, C_icon_plug_colors, C_icon_plug_bitmap},
+  [BAGL_GLYPH_ICON_PLUG] = {BAGL_GLYPH_ICON_PLUG, 24, 15, 4, C_icon_plug_colors, C_icon_plug_bitmap},
 #endif  
 
 #ifdef HAVE_BAGL_GLYPH_BADGE_DOWNLOAD_BLUE
-  {BAGL_GLYPH_BADGE_DOWNLOAD_BLUE, 50, 50, 2, C_badge_download_blue_colors, C_badge_download_blue_bitmap},
+  [BAGL_GLYPH_BADGE_DOWNLOAD_BLUE] = {BAGL_GLYPH_BADGE_DOWNLOAD_BLUE, 50, 50, 2, C_badge_download_blue_colors, C_badge_download_blue_bitmap},
 #endif  
 
 #ifdef HAVE_BAGL_GLYPH_BADGE_WARNING_BLUE
-  {BAGL_GLYPH_BADGE_WARNING_BLUE, 50, 50, 2, C_badge_warning_blue_colors, C_badge_warning_blue_bitmap},
+  [BAGL_GLYPH_BADGE_WARNING_BLUE] = {BAGL_GLYPH_BADGE_WARNING_BLUE, 50, 50, 2, C_badge_warning_blue_colors, C_badge_warning_blue_bitmap},
 #endif  
 
 #ifdef HAVE_BAGL_GLYPH_ICON_LOADER_BLUE
-  {BAGL_GLYPH_ICON_LOADER_BLUE, 50, 50, 2, C_loader_blue_colors, C_loader_blue_bitmap},
+  [BAGL_GLYPH_ICON_LOADER_BLUE] = {BAGL_GLYPH_ICON_LOADER_BLUE, 50, 50, 2, C_loader_blue_colors, C_loader_blue_bitmap},
 #endif  
 
 #ifdef HAVE_BAGL_GLYPH_BADGE_CHECKMARK_BLUE
-  {BAGL_GLYPH_BADGE_CHECKMARK_BLUE, 50, 50, 2, C_badge_checkmark_blue_colors, C_badge_checkmark_blue_bitmap},
+  [BAGL_GLYPH_BADGE_CHECKMARK_BLUE] = {BAGL_GLYPH_BADGE_CHECKMARK_BLUE, 50, 50, 2, C_badge_checkmark_blue_colors, C_badge_checkmark_blue_bitmap},
 #endif
 
 #ifdef HAVE_BAGL_GLYPH_BADGE_WRENCH_BLUE
-  {BAGL_GLYPH_BADGE_WRENCH_BLUE, 50, 50, 2, C_badge_wrench_colors, C_badge_wrench_bitmap},
+  [BAGL_GLYPH_BADGE_WRENCH_BLUE] = {BAGL_GLYPH_BADGE_WRENCH_BLUE, 50, 50, 2, C_badge_wrench_colors, C_badge_wrench_bitmap},
 #endif // HAVE_BAGL_GLYPH_BADGE_WRENCH_BLUE
 
 #ifdef HAVE_BAGL_GLYPH_BADGE_POWER_BLUE
-  {BAGL_GLYPH_BADGE_POWER_BLUE, 50, 50, 2, C_badge_power_colors, C_badge_power_bitmap},
+  [BAGL_GLYPH_BADGE_POWER_BLUE] = {BAGL_GLYPH_BADGE_POWER_BLUE, 50, 50, 2, C_badge_power_colors, C_badge_power_bitmap},
 #endif // HAVE_BAGL_GLYPH_BADGE_POWER_BLUE
 
 #ifdef HAVE_BAGL_GLYPH_BADGE_ERROR_BLUE
-  {BAGL_GLYPH_BADGE_ERROR_BLUE, 50, 50, 2, C_badge_error_colors, C_badge_error_bitmap},
+  [BAGL_GLYPH_BADGE_ERROR_BLUE] = {BAGL_GLYPH_BADGE_ERROR_BLUE, 50, 50, 2, C_badge_error_colors, C_badge_error_bitmap},
 #endif // HAVE_BAGL_GLYPH_BADGE_ERROR_BLUE  
 
 #ifdef HAVE_BAGL_GLYPH_BADGE_CRITICAL_BLUE
-  {BAGL_GLYPH_BADGE_CRITICAL_BLUE, 50, 50, 2, C_badge_critical_colors, C_badge_critical_bitmap},
+  [BAGL_GLYPH_BADGE_CRITICAL_BLUE] = {BAGL_GLYPH_BADGE_CRITICAL_BLUE, 50, 50, 2, C_badge_critical_colors, C_badge_critical_bitmap},
 #endif // HAVE_BAGL_GLYPH_BADGE_CRITICAL_BLUE
 
 #ifdef HAVE_BAGL_GLYPH_BADGE_ASSISTANCE_BLUE
-  {BAGL_GLYPH_BADGE_ASSISTANCE_BLUE, 50, 50, 2, C_badge_assistance_colors, C_badge_assistance_bitmap},
+  [BAGL_GLYPH_BADGE_ASSISTANCE_BLUE] = {BAGL_GLYPH_BADGE_ASSISTANCE_BLUE, 50, 50, 2, C_badge_assistance_colors, C_badge_assistance_bitmap},
 #endif // HAVE_BAGL_GLYPH_BADGE_ASSISTANCE_BLUE
 
 #ifdef HAVE_BAGL_GLYPH_BADGE_LOCK_BLUE
-  {BAGL_GLYPH_BADGE_LOCK_BLUE, 50, 50, 2, C_badge_lock_blue_colors, C_badge_lock_blue_bitmap},
+  [BAGL_GLYPH_BADGE_LOCK_BLUE] = {BAGL_GLYPH_BADGE_LOCK_BLUE, 50, 50, 2, C_badge_lock_blue_colors, C_badge_lock_blue_bitmap},
 #endif // HAVE_BAGL_GLYPH_BADGE_LOCK_BLUE
 
 #ifdef HAVE_BAGL_GLYPH_ICON_CHECKMARK_BLUE
-  {BAGL_GLYPH_ICON_CHECKMARK_BLUE, 12, 12, 2, C_icon_checkmark_colors, C_icon_checkmark_bitmap},
+  [BAGL_GLYPH_ICON_CHECKMARK_BLUE] = {BAGL_GLYPH_ICON_CHECKMARK_BLUE, 12, 12, 2, C_icon_checkmark_colors, C_icon_checkmark_bitmap},
 #endif // HAVE_BAGL_GLYPH_ICON_CHECKMARK_BLUE
 
 #ifdef HAVE_BAGL_GLYPH_APP_FIRMWARE_BLUE
-  {BAGL_GLYPH_APP_FIRMWARE_BLUE, 50, 50, 4, C_app_firmware_colors, C_app_firmware_bitmap},
+  [BAGL_GLYPH_APP_FIRMWARE_BLUE] = {BAGL_GLYPH_APP_FIRMWARE_BLUE, 50, 50, 4, C_app_firmware_colors, C_app_firmware_bitmap},
 #endif // HAVE_BAGL_GLYPH_APP_FIRMWARE_BLUE
 
 #ifdef HAVE_BAGL_GLYPH_BADGE_BLUE
-  {BAGL_GLYPH_BADGE_BLUE, 50, 50, 2, C_badge_blue_colors, C_badge_blue_bitmap},
+  [BAGL_GLYPH_BADGE_BLUE] = {BAGL_GLYPH_BADGE_BLUE, 50, 50, 2, C_badge_blue_colors, C_badge_blue_bitmap},
 #endif // HAVE_BAGL_GLYPH_BADGE_BLUE
   
 #ifdef HAVE_BAGL_GLYPH_ICON_BRIGHTNESS_HIGH_BLUE
-  {BAGL_GLYPH_ICON_BRIGHTNESS_HIGH_BLUE, 18, 18, 2, C_icon_brightness_high_colors, C_icon_brightness_high_bitmap},
+  [BAGL_GLYPH_ICON_BRIGHTNESS_HIGH_BLUE] = {BAGL_GLYPH_ICON_BRIGHTNESS_HIGH_BLUE, 18, 18, 2, C_icon_brightness_high_colors, C_icon_brightness_high_bitmap},
 #endif // HAVE_BAGL_GLYPH_ICON_BRIGHTNESS_HIGH_BLUE
 
 #ifdef HAVE_BAGL_GLYPH_ICON_BRIGHTNESS_LOW_BLUE
-  {BAGL_GLYPH_ICON_BRIGHTNESS_LOW_BLUE, 18, 18, 2, C_icon_brightness_low_colors, C_icon_brightness_low_bitmap},
+  [BAGL_GLYPH_ICON_BRIGHTNESS_LOW_BLUE] = {BAGL_GLYPH_ICON_BRIGHTNESS_LOW_BLUE, 18, 18, 2, C_icon_brightness_low_colors, C_icon_brightness_low_bitmap},
 #endif // HAVE_BAGL_GLYPH_ICON_BRIGHTNESS_LOW_BLUE
 
   
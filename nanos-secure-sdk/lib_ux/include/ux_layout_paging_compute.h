@@ -10,12 +10,22 @@
 # define PAGING_FORMAT_NB         0x0F
 # define PAGING_FORMAT_BB         (PAGING_FORMAT_BN | PAGING_FORMAT_NB)
 
+// number of pages whose start offset is kept when counting the pages
+#ifndef UX_LAYOUT_PAGING_INDEX_SIZE
+#define UX_LAYOUT_PAGING_INDEX_SIZE 16
+#endif // UX_LAYOUT_PAGING_INDEX_SIZE
+
 typedef struct {
   unsigned int current;
   unsigned int count;
 	unsigned char format;
   unsigned short offsets[UX_LAYOUT_PAGING_LINE_COUNT];
   unsigned short lengths[UX_LAYOUT_PAGING_LINE_COUNT];
+  // start offset of the first pages of the text, to display a page without
+  // computing the lines of the previous ones
+  const char* indexed_text;
+  unsigned char indexed_pages;
+  unsigned short page_offsets[UX_LAYOUT_PAGING_INDEX_SIZE];
 } ux_layout_paging_state_t;
 
 unsigned int ux_layout_paging_compute(const char* text_to_split, 
@@ -1,4 +1,5 @@
 #include "os_helpers.h"
+#include "os_math.h"
 #include "os_pic.h"
 #include "ux.h"
 #include "ux_layouts.h"
@@ -8,150 +9,6 @@
 #ifdef HAVE_UX_FLOW
 #ifdef HAVE_BAGL
 
-#if defined(TARGET_NANOS)
-// We implement a light mecanism in order to be able to retrieve the width of
-// nano S characters, in the two possible fonts:
-// - BAGL_FONT_OPEN_SANS_EXTRABOLD_11px,
-// - BAGL_FONT_OPEN_SANS_REGULAR_11px.
-#define NANOS_FIRST_CHAR          0x20
-#define NANOS_LAST_CHAR           0x7F
-
-// OPEN_SANS_REGULAR_11PX << 4 | OPEN_SANS_EXTRABOLD_11PX
-const char nanos_characters_width[96] = {
-   3 << 4 |  3,   /* code 0020 */
-   3 << 4 |  3,   /* code 0021 */
-   4 << 4 |  6,   /* code 0022 */
-   7 << 4 |  7,   /* code 0023 */
-   6 << 4 |  6,   /* code 0024 */
-   9 << 4 | 10,   /* code 0025 */
-   8 << 4 |  9,   /* code 0026 */
-   2 << 4 |  3,   /* code 0027 */
-   3 << 4 |  4,   /* code 0028 */
-   3 << 4 |  4,   /* code 0029 */
-   6 << 4 |  6,   /* code 002A */
-   6 << 4 |  6,   /* code 002B */
-   3 << 4 |  3,   /* code 002C */
-   4 << 4 |  4,   /* code 002D */
-   3 << 4 |  3,   /* code 002E */
-   4 << 4 |  5,   /* code 002F */
-   6 << 4 |  8,   /* code 0030 */
-   6 << 4 |  6,   /* code 0031 */
-   6 << 4 |  7,   /* code 0032 */
-   6 << 4 |  7,   /* code 0033 */
-   8 << 4 |  8,   /* code 0034 */
-   6 << 4 |  6,   /* code 0035 */
-   6 << 4 |  8,   /* code 0036 */
-   6 << 4 |  7,   /* code 0037 */
-   6 << 4 |  8,   /* code 0038 */
-   6 << 4 |  8,   /* code 0039 */
-   3 << 4 |  3,   /* code 003A */
-   3 << 4 |  3,   /* code 003B */
-   6 << 4 |  5,   /* code 003C */
-   6 << 4 |  6,   /* code 003D */
-   6 << 4 |  5,   /* code 003E */
-   5 << 4 |  6,   /* code 003F */
-  10 << 4 | 10,   /* code 0040 */
-   7 << 4 |  8,   /* code 0041 */
-   7 << 4 |  7,   /* code 0042 */
-   7 << 4 |  7,   /* code 0043 */
-   8 << 4 |  8,   /* code 0044 */
-   6 << 4 |  6,   /* code 0045 */
-   6 << 4 |  6,   /* code 0046 */
-   8 << 4 |  8,   /* code 0047 */
-   8 << 4 |  8,   /* code 0048 */
-   3 << 4 |  4,   /* code 0049 */
-   4 << 4 |  5,   /* code 004A */
-   7 << 4 |  8,   /* code 004B */
-   6 << 4 |  6,   /* code 004C */
-  10 << 4 | 11,   /* code 004D */
-   8 << 4 |  9,   /* code 004E */
-   9 << 4 |  9,   /* code 004F */
-   7 << 4 |  7,   /* code 0050 */
-   9 << 4 |  9,   /* code 0051 */
-   7 << 4 |  8,   /* code 0052 */
-   6 << 4 |  6,   /* code 0053 */
-   7 << 4 |  6,   /* code 0054 */
-   8 << 4 |  8,   /* code 0055 */
-   7 << 4 |  6,   /* code 0056 */
-  10 << 4 | 11,   /* code 0057 */
-   6 << 4 |  8,   /* code 0058 */
-   6 << 4 |  7,   /* code 0059 */
-   6 << 4 |  7,   /* code 005A */
-   4 << 4 |  5,   /* code 005B */
-   4 << 4 |  5,   /* code 005C */
-   4 << 4 |  5,   /* code 005D */
-   6 << 4 |  7,   /* code 005E */
-   5 << 4 |  6,   /* code 005F */
-   6 << 4 |  7,   /* code 0060 */
-   6 << 4 |  7,   /* code 0061 */
-   7 << 4 |  7,   /* code 0062 */
-   5 << 4 |  6,   /* code 0063 */
-   7 << 4 |  7,   /* code 0064 */
-   6 << 4 |  7,   /* code 0065 */
-   5 << 4 |  6,   /* code 0066 */
-   6 << 4 |  7,   /* code 0067 */
-   7 << 4 |  7,   /* code 0068 */
-   3 << 4 |  4,   /* code 0069 */
-   4 << 4 |  5,   /* code 006A */
-   6 << 4 |  7,   /* code 006B */
-   3 << 4 |  4,   /* code 006C */
-  10 << 4 | 10,   /* code 006D */
-   7 << 4 |  7,   /* code 006E */
-   7 << 4 |  7,   /* code 006F */
-   7 << 4 |  7,   /* code 0070 */
-   7 << 4 |  7,   /* code 0071 */
-   4 << 4 |  5,   /* code 0072 */
-   5 << 4 |  6,   /* code 0073 */
-   4 << 4 |  5,   /* code 0074 */
-   7 << 4 |  7,   /* code 0075 */
-   6 << 4 |  7,   /* code 0076 */
-   9 << 4 | 10,   /* code 0077 */
-   6 << 4 |  7,   /* code 0078 */
-   6 << 4 |  7,   /* code 0079 */
-   5 << 4 |  6,   /* code 007A */
-   4 << 4 |  5,   /* code 007B */
-   6 << 4 |  6,   /* code 007C */
-   4 << 4 |  5,   /* code 007D */
-   6 << 4 |  6,   /* code 007E */
-   7 << 4 |  6,   /* code 007F */
-};
-
-// This function is used to retrieve the width of a line of text.
-// The formatting of the characters (BAGL_FONT_OPEN_SANS_EXTRABOLD_11px or
-// BAGL_FONT_OPEN_SANS_REGULAR_11px) is indicated within the 'G_ux.layout_paging.format'
-// variable when entering here.
-static unsigned short se_compute_line_width_light(const char* text, unsigned char text_length) {
-  char current_char;
-  unsigned short line_width = 0;
-
-  // We parse the characters of the input text on all the input length.
-  while (text_length--) {
-    current_char = *text;
-
-    if (current_char < NANOS_FIRST_CHAR || current_char > NANOS_LAST_CHAR) {
-      if (current_char == '\n' || current_char == '\r') {
-        break;
-      }
-    }
-    else {
-      // We retrieve the character width, and the paging format indicates whether we are
-      // processing bold characters or not.
-      if ((G_ux.layout_paging.format & PAGING_FORMAT_NB) == PAGING_FORMAT_NB) {
-        // Bold.
-        line_width += nanos_characters_width[current_char - NANOS_FIRST_CHAR] & 0x0F;
-      }
-      else {
-        // Regular.
-        line_width += (nanos_characters_width[current_char - NANOS_FIRST_CHAR] >> 0x04) & 0x0F;
-      }
-    }
-    text++;
-  }
-  return line_width;
-}
-
-#endif // TARGET_NANOS
-
 static unsigned int is_word_delim(unsigned char c) {
   // return !((c >= 'a' && c <= 'z') 
   //       || (c >= 'A' && c <= 'Z')
@@ -159,16 +16,52 @@ static unsigned int is_word_delim(unsigned char c) {
   return c == ' ' || c == '\n' || c == '\t' || c == '-' || c == '_';
 }
 
+// compute the length of the line starting at 'start', cut at the previous word
+// delimiter if the line is full in the middle of a word
+static unsigned int ux_layout_paging_compute_line(const char* start,
+                                                  const char* end,
+                                                  bagl_font_id_e font) {
+  bagl_text_metrics_t metrics;
+
+#ifndef TARGET_NANOX
+  // the lines are drawn in bold or regular depending on the paging format
+  font = ((G_ux.layout_paging.format & PAGING_FORMAT_NB) == PAGING_FORMAT_NB) ?
+    BAGL_FONT_OPEN_SANS_EXTRABOLD_11px : BAGL_FONT_OPEN_SANS_REGULAR_11px;
+#endif // TARGET_NANOX
+
+  // measure the line at once, up to the first line break or to the character
+  // which does not fit
+  bagl_compute_text_metrics(font, PIXEL_PER_LINE, start, MIN(end - start, 0xFFFF),
+                            BAGL_ENCODING_LATIN1, &metrics);
+  unsigned int len = metrics.length;
+
+  if (metrics.line_break) {
+    // characters after a line break do not count, the line goes up to the
+    // next '\n' included
+    while (start + len < end && start[len++] != '\n');
+    return len;
+  }
+
+  // if not splitting line onto a word delimiter, then cut at the previous word_delim, adjust len accordingly (and a wor delim has been found already)
+  if (start + len < end && metrics.last_delim && len) {
+    // if line split within a word
+    if ((!is_word_delim(start[len-1]) && !is_word_delim(start[len]))) {
+      len = metrics.last_delim;
+    }
+  }
+  return len;
+}
+
 // return the number of pages to be displayed when current page to show is -1
+//
+// Counting the pages also records where the first UX_LAYOUT_PAGING_INDEX_SIZE
+// pages start, so that displaying one of them only computes its own lines,
+// instead of all the lines of the previous pages.
 unsigned int ux_layout_paging_compute(const char* text_to_split, 
                                       unsigned int page_to_display,
                                       ux_layout_paging_state_t* paging_state,
                                       bagl_font_id_e font
                                       ) {
-#ifndef TARGET_NANOX
-  UNUSED(font);
-#endif
-
   // reset length and offset of lines
   memset(paging_state->offsets, 0, sizeof(paging_state->offsets));
   memset(paging_state->lengths, 0, sizeof(paging_state->lengths));
@@ -184,46 +77,25 @@ unsigned int ux_layout_paging_compute(const char* text_to_split,
   const char* start = (text_to_split ? STRPIC(text_to_split) : G_ux.externalText);
   const char* start2 = start;
   const char* end = start + strlen(start);
+
+  if (page_to_display == -1UL) {
+    // the index is rebuilt while counting
+    paging_state->indexed_text = start2;
+    paging_state->indexed_pages = 0;
+  }
+  else if (paging_state->indexed_text == start2 && paging_state->indexed_pages) {
+    // resume from the closest indexed page
+    page = MIN(page_to_display, paging_state->indexed_pages - 1U);
+    start += paging_state->page_offsets[page];
+  }
+
   while (start < end) {
-    unsigned int len = 0;
-    unsigned int linew = 0; 
-    const char* last_word_delim = start;
-    // not reached end of content
-    while (start + len < end
-      // line is not full
-      && linew <= PIXEL_PER_LINE
-      // avoid display buffer overflow for each line
-      // && len < sizeof(G_ux.string_buffer)-1
-      ) {
-      // compute new line length
-#ifdef TARGET_NANOX
-      linew = bagl_compute_line_width(font, 0, start, len+1, BAGL_ENCODING_LATIN1);
-#else // TARGET_NANOX
-      linew = se_compute_line_width_light(start, len + 1);
-#endif //TARGET_NANOX
-      //if (start[len] )
-      if (linew > PIXEL_PER_LINE) {
-        // we got a full line
-        break;
-      }
-      unsigned char c = start[len];
-      if (is_word_delim(c)) {
-        last_word_delim = &start[len];
-      }
-      len++;
-      // new line, don't go further
-      if (c == '\n') {
-        break;
-      }
+    if (page_to_display == -1UL && line == 0 && page < UX_LAYOUT_PAGING_INDEX_SIZE) {
+      paging_state->page_offsets[page] = start - start2;
+      paging_state->indexed_pages = page + 1;
     }
 
-    // if not splitting line onto a word delimiter, then cut at the previous word_delim, adjust len accordingly (and a wor delim has been found already)
-    if (start + len < end && last_word_delim != start && len) {
-      // if line split within a word
-      if ((!is_word_delim(start[len-1]) && !is_word_delim(start[len]))) {
-        len = last_word_delim - start;
-      }
-    }
+    unsigned int len = ux_layout_paging_compute_line(start, end, font);
 
     // fill up the paging structure
     if (page_to_display != -1UL && page_to_display == page && page_to_display < paging_state->count) {
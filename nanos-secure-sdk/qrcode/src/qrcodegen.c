@@ -80,7 +80,12 @@ static void fillRectangle(int left, int top, int width, int height, uint8_t qrco
 
 static void drawCodewords(const uint8_t data[], int dataLen, uint8_t qrcode[]);
 static void applyMask(const uint8_t functionModules[], uint8_t qrcode[], enum qrcodegen_Mask mask);
+static uint32_t getMaskRow(enum qrcodegen_Mask mask, int y);
 static long getPenaltyScore(const uint8_t qrcode[]);
+static uint32_t getRowBits(const uint8_t qrcode[], int x, int y);
+static uint32_t lowBits(int count);
+static int popCount(uint32_t x);
+static uint32_t getFinderLikeBits(const uint32_t m[11]);
 
 testable bool getModule(const uint8_t qrcode[], int x, int y);
 testable void setModule(uint8_t qrcode[], int x, int y, bool isBlack);
@@ -104,6 +109,46 @@ testable const int8_t NUM_ERROR_CORRECTION_BLOCKS[][41] = {
 	{-1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 4,  4,  4,  4,  4,  6,  6,  6,  6,  7,  8,  8,  9,  9, 10, 12, 12, 12, 13, 14, 15, 16, 17, 18, 19, 19, 20, 21, 22, 24, 25},  // Low
 };
 
+// For Reed-Solomon ECC: GF256_EXP[i] = 0x02^i and GF256_LOG[GF256_EXP[i]] = i, in the field GF(2^8/0x11D).
+// GF256_LOG[0] is unused, as zero has no logarithm.
+testable const uint8_t GF256_EXP[255] = {
+	0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1D, 0x3A, 0x74, 0xE8, 0xCD, 0x87, 0x13, 0x26,
+	0x4C, 0x98, 0x2D, 0x5A, 0xB4, 0x75, 0xEA, 0xC9, 0x8F, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0,
+	0x9D, 0x27, 0x4E, 0x9C, 0x25, 0x4A, 0x94, 0x35, 0x6A, 0xD4, 0xB5, 0x77, 0xEE, 0xC1, 0x9F, 0x23,
+	0x46, 0x8C, 0x05, 0x0A, 0x14, 0x28, 0x50, 0xA0, 0x5D, 0xBA, 0x69, 0xD2, 0xB9, 0x6F, 0xDE, 0xA1,
+	0x5F, 0xBE, 0x61, 0xC2, 0x99, 0x2F, 0x5E, 0xBC, 0x65, 0xCA, 0x89, 0x0F, 0x1E, 0x3C, 0x78, 0xF0,
+	0xFD, 0xE7, 0xD3, 0xBB, 0x6B, 0xD6, 0xB1, 0x7F, 0xFE, 0xE1, 0xDF, 0xA3, 0x5B, 0xB6, 0x71, 0xE2,
+	0xD9, 0xAF, 0x43, 0x86, 0x11, 0x22, 0x44, 0x88, 0x0D, 0x1A, 0x34, 0x68, 0xD0, 0xBD, 0x67, 0xCE,
+	0x81, 0x1F, 0x3E, 0x7C, 0xF8, 0xED, 0xC7, 0x93, 0x3B, 0x76, 0xEC, 0xC5, 0x97, 0x33, 0x66, 0xCC,
+	0x85, 0x17, 0x2E, 0x5C, 0xB8, 0x6D, 0xDA, 0xA9, 0x4F, 0x9E, 0x21, 0x42, 0x84, 0x15, 0x2A, 0x54,
+	0xA8, 0x4D, 0x9A, 0x29, 0x52, 0xA4, 0x55, 0xAA, 0x49, 0x92, 0x39, 0x72, 0xE4, 0xD5, 0xB7, 0x73,
+	0xE6, 0xD1, 0xBF, 0x63, 0xC6, 0x91, 0x3F, 0x7E, 0xFC, 0xE5, 0xD7, 0xB3, 0x7B, 0xF6, 0xF1, 0xFF,
+	0xE3, 0xDB, 0xAB, 0x4B, 0x96, 0x31, 0x62, 0xC4, 0x95, 0x37, 0x6E, 0xDC, 0xA5, 0x57, 0xAE, 0x41,
+	0x82, 0x19, 0x32, 0x64, 0xC8, 0x8D, 0x07, 0x0E, 0x1C, 0x38, 0x70, 0xE0, 0xDD, 0xA7, 0x53, 0xA6,
+	0x51, 0xA2, 0x59, 0xB2, 0x79, 0xF2, 0xF9, 0xEF, 0xC3, 0x9B, 0x2B, 0x56, 0xAC, 0x45, 0x8A, 0x09,
+	0x12, 0x24, 0x48, 0x90, 0x3D, 0x7A, 0xF4, 0xF5, 0xF7, 0xF3, 0xFB, 0xEB, 0xCB, 0x8B, 0x0B, 0x16,
+	0x2C, 0x58, 0xB0, 0x7D, 0xFA, 0xE9, 0xCF, 0x83, 0x1B, 0x36, 0x6C, 0xD8, 0xAD, 0x47, 0x8E,
+};
+
+testable const uint8_t GF256_LOG[256] = {
+	0x00, 0x00, 0x01, 0x19, 0x02, 0x32, 0x1A, 0xC6, 0x03, 0xDF, 0x33, 0xEE, 0x1B, 0x68, 0xC7, 0x4B,
+	0x04, 0x64, 0xE0, 0x0E, 0x34, 0x8D, 0xEF, 0x81, 0x1C, 0xC1, 0x69, 0xF8, 0xC8, 0x08, 0x4C, 0x71,
+	0x05, 0x8A, 0x65, 0x2F, 0xE1, 0x24, 0x0F, 0x21, 0x35, 0x93, 0x8E, 0xDA, 0xF0, 0x12, 0x82, 0x45,
+	0x1D, 0xB5, 0xC2, 0x7D, 0x6A, 0x27, 0xF9, 0xB9, 0xC9, 0x9A, 0x09, 0x78, 0x4D, 0xE4, 0x72, 0xA6,
+	0x06, 0xBF, 0x8B, 0x62, 0x66, 0xDD, 0x30, 0xFD, 0xE2, 0x98, 0x25, 0xB3, 0x10, 0x91, 0x22, 0x88,
+	0x36, 0xD0, 0x94, 0xCE, 0x8F, 0x96, 0xDB, 0xBD, 0xF1, 0xD2, 0x13, 0x5C, 0x83, 0x38, 0x46, 0x40,
+	0x1E, 0x42, 0xB6, 0xA3, 0xC3, 0x48, 0x7E, 0x6E, 0x6B, 0x3A, 0x28, 0x54, 0xFA, 0x85, 0xBA, 0x3D,
+	0xCA, 0x5E, 0x9B, 0x9F, 0x0A, 0x15, 0x79, 0x2B, 0x4E, 0xD4, 0xE5, 0xAC, 0x73, 0xF3, 0xA7, 0x57,
+	0x07, 0x70, 0xC0, 0xF7, 0x8C, 0x80, 0x63, 0x0D, 0x67, 0x4A, 0xDE, 0xED, 0x31, 0xC5, 0xFE, 0x18,
+	0xE3, 0xA5, 0x99, 0x77, 0x26, 0xB8, 0xB4, 0x7C, 0x11, 0x44, 0x92, 0xD9, 0x23, 0x20, 0x89, 0x2E,
+	0x37, 0x3F, 0xD1, 0x5B, 0x95, 0xBC, 0xCF, 0xCD, 0x90, 0x87, 0x97, 0xB2, 0xDC, 0xFC, 0xBE, 0x61,
+	0xF2, 0x56, 0xD3, 0xAB, 0x14, 0x2A, 0x5D, 0x9E, 0x84, 0x3C, 0x39, 0x53, 0x47, 0x6D, 0x41, 0xA2,
+	0x1F, 0x2D, 0x43, 0xD8, 0xB7, 0x7B, 0xA4, 0x76, 0xC4, 0x17, 0x49, 0xEC, 0x7F, 0x0C, 0x6F, 0xF6,
+	0x6C, 0xA1, 0x3B, 0x52, 0x29, 0x9D, 0x55, 0xAA, 0xFB, 0x60, 0x86, 0xB1, 0xBB, 0xCC, 0x3E, 0x5A,
+	0xCB, 0x59, 0x5F, 0xB0, 0x9C, 0xA9, 0xA0, 0x51, 0x0B, 0xF5, 0x16, 0xEB, 0x7A, 0x75, 0x2C, 0xD7,
+	0x4F, 0xAE, 0xD5, 0xE9, 0xE6, 0xE7, 0xAD, 0xE8, 0x74, 0xD6, 0xF4, 0xEA, 0xA8, 0x50, 0x58, 0xAF,
+};
+
 // For automatic mask pattern selection.
 static const int PENALTY_N1 = 3;
 static const int PENALTY_N2 = 3;
@@ -232,10 +277,16 @@ static void encodeQrCodeTail(uint8_t dataAndQrcode[], int bitLen, uint8_t tempBu
 
 
 // Appends the given sequence of bits to the given byte-based bit buffer, increasing the bit length.
+// The bits are written as many at a time as fit in the current byte, so at most 3 iterations.
 testable void appendBitsToBuffer(unsigned int val, int numBits, uint8_t buffer[], int *bitLen) {
 	assert(0 <= numBits && numBits <= 16 && (long)val >> numBits == 0);
-	for (int i = numBits - 1; i >= 0; i--, (*bitLen)++)
-		buffer[*bitLen >> 3] |= ((val >> i) & 1) << (7 - (*bitLen & 7));
+	while (numBits > 0) {
+		int free = 8 - (*bitLen & 7);  // Unused bits left in the current byte
+		int n = numBits < free ? numBits : free;
+		numBits -= n;
+		buffer[*bitLen >> 3] |= ((val >> numBits) & ((1U << n) - 1)) << (free - n);
+		*bitLen += n;
+	}
 }
 
 
@@ -323,15 +374,14 @@ testable void calcReedSolomonGenerator(int degree, uint8_t result[]) {
 	// Compute the product polynomial (x - r^0) * (x - r^1) * (x - r^2) * ... * (x - r^{degree-1}),
 	// drop the highest term, and store the rest of the coefficients in order of descending powers.
 	// Note that r = 0x02, which is a generator element of this field GF(2^8/0x11D).
-	uint8_t root = 1;
 	for (int i = 0; i < degree; i++) {
 		// Multiply the current product by (x - r^i)
+		uint8_t root = GF256_EXP[i];
 		for (int j = 0; j < degree; j++) {
 			result[j] = finiteFieldMultiply(result[j], root);
 			if (j + 1 < degree)
 				result[j] ^= result[j + 1];
 		}
-		root = finiteFieldMultiply(root, 0x02);
 	}
 }
 
@@ -339,29 +389,38 @@ testable void calcReedSolomonGenerator(int degree, uint8_t result[]) {
 // Calculates the remainder of the polynomial data[0 : dataLen] when divided by the generator[0 : degree], where all
 // polynomials are in big endian and the generator has an implicit leading 1 term, storing the result in result[0 : degree].
 testable void calcReedSolomonRemainder(const uint8_t data[], int dataLen, const uint8_t generator[], int degree, uint8_t result[]) {
-	// Perform polynomial division
+	// The coefficients of a generator are never zero, so they are kept as logarithms
 	assert(1 <= degree && degree <= 30);
+	uint8_t generatorLog[30];
+	for (int j = 0; j < degree; j++) {
+		assert(generator[j] != 0);
+		generatorLog[j] = GF256_LOG[generator[j]];
+	}
+	
+	// Perform polynomial division
 	memset(result, 0, degree * sizeof(result[0]));
 	for (int i = 0; i < dataLen; i++) {
 		uint8_t factor = data[i] ^ result[0];
 		memmove(&result[0], &result[1], (degree - 1) * sizeof(result[0]));
 		result[degree - 1] = 0;
-		for (int j = 0; j < degree; j++)
-			result[j] ^= finiteFieldMultiply(generator[j], factor);
+		if (factor == 0)
+			continue;
+		int factorLog = GF256_LOG[factor];
+		for (int j = 0; j < degree; j++) {
+			int k = generatorLog[j] + factorLog;
+			result[j] ^= GF256_EXP[k < 255 ? k : k - 255];
+		}
 	}
 }
 
 
 // Returns the product of the two given field elements modulo GF(2^8/0x11D).
-// All inputs are valid. This could be implemented as a 256*256 lookup table.
+// All inputs are valid. This adds the logarithms of the operands.
 testable uint8_t finiteFieldMultiply(uint8_t x, uint8_t y) {
-	// Russian peasant multiplication
-	uint8_t z = 0;
-	for (int i = 7; i >= 0; i--) {
-		z = (z << 1) ^ ((z >> 7) * 0x11D);
-		z ^= ((y >> i) & 1) * x;
-	}
-	return z;
+	if (x == 0 || y == 0)
+		return 0;
+	int k = GF256_LOG[x] + GF256_LOG[y];
+	return GF256_EXP[k < 255 ? k : k - 255];
 }
 
 
@@ -568,111 +627,178 @@ static void drawCodewords(const uint8_t data[], int dataLen, uint8_t qrcode[]) {
 }
 
 
+// Returns the inversions of the given mask pattern for the modules 0 to 5 of row y, in the lowest bits.
+// All the patterns have a period of 6 modules horizontally, so the result is repeated up to bit 31.
+static uint32_t getMaskRow(enum qrcodegen_Mask mask, int y) {
+	uint32_t result = 0;
+	for (int x = 0; x < 6; x++) {
+		bool invert = 0;
+		switch ((int)mask) {
+			case 0:  invert = (x + y) % 2 == 0;                    break;
+			case 1:  invert = y % 2 == 0;                          break;
+			case 2:  invert = x % 3 == 0;                          break;
+			case 3:  invert = (x + y) % 3 == 0;                    break;
+			case 4:  invert = (x / 3 + y / 2) % 2 == 0;            break;
+			case 5:  invert = x * y % 2 + x * y % 3 == 0;          break;
+			case 6:  invert = (x * y % 2 + x * y % 3) % 2 == 0;    break;
+			case 7:  invert = ((x + y) % 2 + x * y % 3) % 2 == 0;  break;
+			default:  assert(false);
+		}
+		result |= (uint32_t)invert << x;
+	}
+	return result | result << 6 | result << 12 | result << 18 | result << 24 | result << 30;
+}
+
+
 // XORs the data modules in this QR Code with the given mask pattern. Due to XOR's mathematical
 // properties, calling applyMask(..., m) twice with the same value is equivalent to no change at all.
 // This means it is possible to apply a mask, undo it, and try another mask. Note that a final
 // well-formed QR Code symbol needs exactly one mask applied (not zero, not two, etc.).
+// The modules are inverted a byte (8 modules) at a time, a byte overlapping at most two rows.
 static void applyMask(const uint8_t functionModules[], uint8_t qrcode[], enum qrcodegen_Mask mask) {
 	assert(0 <= (int)mask && (int)mask <= 7);  // Disallows qrcodegen_Mask_AUTO
 	int qrsize = qrcodegen_getSize(qrcode);
-	for (int y = 0; y < qrsize; y++) {
-		for (int x = 0; x < qrsize; x++) {
-			if (getModule(functionModules, x, y))
-				continue;
-			bool invert = 0;
-			switch ((int)mask) {
-				case 0:  invert = (x + y) % 2 == 0;                    break;
-				case 1:  invert = y % 2 == 0;                          break;
-				case 2:  invert = x % 3 == 0;                          break;
-				case 3:  invert = (x + y) % 3 == 0;                    break;
-				case 4:  invert = (x / 3 + y / 2) % 2 == 0;            break;
-				case 5:  invert = x * y % 2 + x * y % 3 == 0;          break;
-				case 6:  invert = (x * y % 2 + x * y % 3) % 2 == 0;    break;
-				case 7:  invert = ((x + y) % 2 + x * y % 3) % 2 == 0;  break;
-				default:  assert(false);
-			}
-			bool val = getModule(qrcode, x, y);
-			setModule(qrcode, x, y, val ^ invert);
+	int numBytes = (qrsize * qrsize + 7) / 8;
+	uint32_t row = getMaskRow(mask, 0);
+	uint32_t nextRow = getMaskRow(mask, 1);
+	for (int i = 0, x = 0, y = 0, x6 = 0; i < numBytes; i++) {
+		// x is the column of the first module of the byte, and x6 is x modulo 6
+		uint32_t invert = row >> x6;
+		int left = qrsize - x;  // Modules of the byte in row y
+		if (left < 8) {
+			invert &= (1U << left) - 1;
+			if (y + 1 < qrsize)
+				invert |= nextRow << left;
+		}
+		qrcode[i + 1] ^= (uint8_t)invert & ~functionModules[i + 1];
+		
+		x += 8;
+		x6 += 8 - 6;
+		if (x6 >= 6)
+			x6 -= 6;
+		if (x >= qrsize) {
+			x -= qrsize;
+			x6 = x % 6;
+			y++;
+			row = nextRow;
+			nextRow = getMaskRow(mask, y + 1);
 		}
 	}
 }
 
 
+// Returns the modules [x, x + 32) of row y of the given QR Code, the module x in the lowest bit.
+// The modules beyond the end of the row are white.
+static uint32_t getRowBits(const uint8_t qrcode[], int x, int y) {
+	int qrsize = qrcode[0];
+	int count = qrsize - x;
+	if (count > 32)
+		count = 32;
+	int index = y * qrsize + x;
+	const uint8_t *bytes = &qrcode[(index >> 3) + 1];
+	uint32_t result = 0;
+	for (int pos = -(index & 7); pos < count; pos += 8, bytes++)
+		result |= pos < 0 ? (uint32_t)*bytes >> -pos : (uint32_t)*bytes << pos;
+	if (count < 32)
+		result &= (1U << count) - 1;
+	return result;
+}
+
+
+// Returns a word with the lowest count bits set, where count is clamped to the range [0, 32].
+static uint32_t lowBits(int count) {
+	if (count <= 0)
+		return 0;
+	if (count >= 32)
+		return UINT32_MAX;
+	return (1U << count) - 1;
+}
+
+
+// Returns the number of set bits of the given word.
+static int popCount(uint32_t x) {
+	x -= (x >> 1) & 0x55555555;
+	x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+	x = (x + (x >> 4)) & 0x0F0F0F0F;
+	return (int)((x * 0x01010101) >> 24);
+}
+
+
+// Returns the bits where the 11 given words, in reading order, match a finder-like pattern: 1:1:3:1:1
+// dark and light modules, preceded or followed by 4 light modules (bits 0x05D or 0x5D0 read in order).
+static uint32_t getFinderLikeBits(const uint32_t m[11]) {
+	uint32_t lightFirst = ~(m[0] | m[1] | m[2] | m[3]);
+	uint32_t lightLast = ~(m[7] | m[8] | m[9] | m[10]);
+	uint32_t coreFirst = m[0] & ~m[1] & m[2] & m[3] & m[4] & ~m[5] & m[6];
+	uint32_t coreLast = m[4] & ~m[5] & m[6] & m[7] & m[8] & ~m[9] & m[10];
+	return (lightFirst & coreLast) | (coreFirst & lightLast);
+}
+
+
+// The number of columns scored at once by getPenaltyScore(), so that a 32-bit
+// word also holds the 10 following modules of the finder-like patterns in rows.
+#define PENALTY_STRIP_WIDTH  22
+
 // Calculates and returns the penalty score based on state of the given QR Code's current modules.
 // This is used by the automatic mask choice algorithm to find the mask pattern that yields the lowest score.
+// The QR Code is scanned in strips of columns, each row of a strip being a word with one module per bit.
+// The bit j of the words tells whether a pattern starts at the module j of a row, or ends at the module j
+// of a column, and the patterns are counted with popCount(). Scoring runs of N >= 5 modules with the
+// same color by N1 + (N - 5) is the same as counting N1 for each run of at least 5 modules (N - 4
+// sequences of 5 modules with the same color minus N - 5 sequences of 6), and 1 for each sequence of 6.
 static long getPenaltyScore(const uint8_t qrcode[]) {
 	int qrsize = qrcodegen_getSize(qrcode);
 	long result = 0;
+	int black = 0;
 	
-	// Adjacent modules in row having same color
-	for (int y = 0; y < qrsize; y++) {
-		bool colorX;
-		for (int x = 0, runX; x < qrsize; x++) {
-			if (x == 0 || getModule(qrcode, x, y) != colorX) {
-				colorX = getModule(qrcode, x, y);
-				runX = 1;
-			} else {
-				runX++;
-				if (runX == 5)
-					result += PENALTY_N1;
-				else if (runX > 5)
-					result++;
+	for (int x = 0; x < qrsize; x += PENALTY_STRIP_WIDTH) {
+		int width = qrsize - x;  // Columns of the strip
+		if (width > PENALTY_STRIP_WIDTH)
+			width = PENALTY_STRIP_WIDTH;
+		uint32_t columns = lowBits(width);
+		uint32_t column[11] = {0};  // The last 11 rows of the strip, the current one last
+		for (int y = 0; y < qrsize; y++) {
+			uint32_t bits = getRowBits(qrcode, x, y);
+			uint32_t prev = column[10];
+			memmove(&column[0], &column[1], 10 * sizeof(column[0]));
+			column[10] = bits;
+			black += popCount(bits & columns);
+			
+			// Adjacent modules in row having same color
+			uint32_t row[11];
+			for (int i = 0; i < 11; i++)
+				row[i] = bits >> i;
+			uint32_t same5 = ~(row[0] ^ row[1]) & ~(row[1] ^ row[2]) & ~(row[2] ^ row[3]) & ~(row[3] ^ row[4]);
+			uint32_t same6 = same5 & ~(row[4] ^ row[5]);
+			int runs5 = popCount(same5 & lowBits(qrsize - x - 4) & columns);
+			int runs6 = popCount(same6 & lowBits(qrsize - x - 5) & columns);
+			result += PENALTY_N1 * (runs5 - runs6) + runs6;
+			
+			// Adjacent modules in column having same color
+			if (y >= 4) {
+				same5 = ~(column[6] ^ column[7]) & ~(column[7] ^ column[8]) & ~(column[8] ^ column[9]) & ~(column[9] ^ column[10]);
+				same6 = y >= 5 ? same5 & ~(column[5] ^ column[6]) : 0;
+				runs5 = popCount(same5 & columns);
+				runs6 = popCount(same6 & columns);
+				result += PENALTY_N1 * (runs5 - runs6) + runs6;
 			}
-		}
-	}
-	// Adjacent modules in column having same color
-	for (int x = 0; x < qrsize; x++) {
-		bool colorY;
-		for (int y = 0, runY; y < qrsize; y++) {
-			if (y == 0 || getModule(qrcode, x, y) != colorY) {
-				colorY = getModule(qrcode, x, y);
-				runY = 1;
-			} else {
-				runY++;
-				if (runY == 5)
-					result += PENALTY_N1;
-				else if (runY > 5)
-					result++;
+			
+			// 2*2 blocks of modules having same color, with the previous row
+			if (y >= 1) {
+				uint32_t same = ~(bits ^ prev);
+				uint32_t blocks = ~(bits ^ (bits >> 1)) & same & (same >> 1);
+				result += PENALTY_N2 * popCount(blocks & lowBits(qrsize - x - 1) & columns);
 			}
-		}
-	}
-	
-	// 2*2 blocks of modules having same color
-	for (int y = 0; y < qrsize - 1; y++) {
-		for (int x = 0; x < qrsize - 1; x++) {
-			bool  color = getModule(qrcode, x, y);
-			if (  color == getModule(qrcode, x + 1, y) &&
-			      color == getModule(qrcode, x, y + 1) &&
-			      color == getModule(qrcode, x + 1, y + 1))
-				result += PENALTY_N2;
-		}
-	}
-	
-	// Finder-like pattern in rows
-	for (int y = 0; y < qrsize; y++) {
-		for (int x = 0, bits = 0; x < qrsize; x++) {
-			bits = ((bits << 1) & 0x7FF) | (getModule(qrcode, x, y) ? 1 : 0);
-			if (x >= 10 && (bits == 0x05D || bits == 0x5D0))  // Needs 11 bits accumulated
-				result += PENALTY_N3;
-		}
-	}
-	// Finder-like pattern in columns
-	for (int x = 0; x < qrsize; x++) {
-		for (int y = 0, bits = 0; y < qrsize; y++) {
-			bits = ((bits << 1) & 0x7FF) | (getModule(qrcode, x, y) ? 1 : 0);
-			if (y >= 10 && (bits == 0x05D || bits == 0x5D0))  // Needs 11 bits accumulated
-				result += PENALTY_N3;
+			
+			// Finder-like pattern in rows
+			result += PENALTY_N3 * popCount(getFinderLikeBits(row) & lowBits(qrsize - x - 10) & columns);
+			// Finder-like pattern in columns
+			if (y >= 10)
+				result += PENALTY_N3 * popCount(getFinderLikeBits(column) & columns);
 		}
 	}
 	
 	// Balance of black and white modules
-	int black = 0;
-	for (int y = 0; y < qrsize; y++) {
-		for (int x = 0; x < qrsize; x++) {
-			if (getModule(qrcode, x, y))
-				black++;
-		}
-	}
 	int total = qrsize * qrsize;
 	// Find smallest k such that (45-5k)% <= dark/total <= (55+5k)%
 	for (int k = 0; black*20L < (9L-k)*total || black*20L > (11L+k)*total; k++)
@@ -0,0 +1,131 @@
+/* Generated by fontwidths.py from the fonts of lib_bagl, do not edit */
+
+#include "bagl.h"
+
+#ifdef HAVE_BAGL
+
+static const unsigned char widthsLUCIDA_CONSOLE_8[96] = {
+  0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+  0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+  0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+  0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+  0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+  0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+  0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+  0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+};
+
+static const unsigned char widthsOPEN_SANS_EXTRABOLD_11PX[48] = {
+  0x33, 0x76, 0xa6, 0x39, 0x44, 0x66, 0x43, 0x53, 0x68, 0x77, 0x68, 0x78,
+  0x88, 0x33, 0x65, 0x65, 0x8a, 0x77, 0x68, 0x86, 0x48, 0x85, 0xb6, 0x99,
+  0x97, 0x68, 0x86, 0xb6, 0x78, 0x57, 0x55, 0x67, 0x77, 0x67, 0x77, 0x76,
+  0x47, 0x75, 0xa4, 0x77, 0x77, 0x65, 0x75, 0xa7, 0x77, 0x56, 0x56, 0x66,
+};
+
+static const unsigned char widthsOPEN_SANS_LIGHT_16PX[48] = {
+  0x34, 0xa6, 0xd9, 0x3b, 0x44, 0x99, 0x53, 0x54, 0x99, 0x99, 0x9b, 0x99,
+  0x99, 0x44, 0x99, 0x79, 0xae, 0xaa, 0x9b, 0xc8, 0x4c, 0x97, 0xe8, 0xcc,
+  0xc9, 0x9a, 0xc7, 0xe9, 0x89, 0x59, 0x55, 0x79, 0x89, 0x8a, 0x9a, 0x86,
+  0x49, 0x85, 0xe4, 0x99, 0xaa, 0x76, 0x95, 0xc7, 0x78, 0x67, 0x69, 0xa9,
+};
+
+static const unsigned char widthsOPEN_SANS_REGULAR_11PX[48] = {
+  0x33, 0x74, 0x96, 0x28, 0x33, 0x66, 0x43, 0x43, 0x66, 0x66, 0x68, 0x66,
+  0x66, 0x33, 0x66, 0x56, 0x7a, 0x77, 0x68, 0x86, 0x38, 0x74, 0xa6, 0x98,
+  0x97, 0x67, 0x87, 0xa7, 0x66, 0x46, 0x44, 0x56, 0x66, 0x57, 0x67, 0x65,
+  0x37, 0x64, 0xa3, 0x77, 0x77, 0x54, 0x74, 0x96, 0x66, 0x45, 0x46, 0x76,
+};
+
+static const unsigned char widthsOPEN_SANS_LIGHT_16_22PX[96] = {
+  0x05, 0x05, 0x07, 0x0e, 0x0c, 0x11, 0x0f, 0x04, 0x06, 0x06, 0x0c, 0x0c,
+  0x05, 0x07, 0x05, 0x07, 0x0c, 0x0c, 0x0c, 0x0c, 0x0c, 0x0c, 0x0c, 0x0c,
+  0x0c, 0x0c, 0x05, 0x05, 0x0c, 0x0c, 0x0c, 0x09, 0x13, 0x0d, 0x0d, 0x0d,
+  0x0f, 0x0c, 0x0b, 0x0f, 0x0f, 0x05, 0x06, 0x0c, 0x0b, 0x12, 0x0f, 0x10,
+  0x0c, 0x10, 0x0c, 0x0b, 0x0b, 0x0f, 0x0c, 0x13, 0x0b, 0x0b, 0x0c, 0x07,
+  0x07, 0x07, 0x0c, 0x09, 0x0c, 0x0b, 0x0c, 0x0a, 0x0c, 0x0c, 0x08, 0x0b,
+  0x0c, 0x05, 0x05, 0x0a, 0x05, 0x13, 0x0c, 0x0c, 0x0c, 0x0c, 0x08, 0x0a,
+  0x07, 0x0c, 0x0a, 0x0f, 0x0a, 0x0a, 0x0a, 0x07, 0x0b, 0x07, 0x0c, 0x0d,
+};
+
+static const unsigned char widthsOPEN_SANS_SEMIBOLD_10_13PX[48] = {
+  0x43, 0x86, 0xb7, 0x3a, 0x44, 0x77, 0x43, 0x54, 0x77, 0x77, 0x77, 0x77,
+  0x77, 0x44, 0x77, 0x67, 0x9c, 0x89, 0x7a, 0x97, 0x4a, 0x84, 0xc7, 0xaa,
+  0xa8, 0x78, 0xa7, 0xc8, 0x88, 0x47, 0x45, 0x67, 0x88, 0x68, 0x78, 0x76,
+  0x48, 0x74, 0xc4, 0x88, 0x88, 0x66, 0x85, 0xb7, 0x77, 0x56, 0x57, 0x87,
+};
+
+static const unsigned char widthsOPEN_SANS_SEMIBOLD_11_16PX[48] = {
+  0x44, 0xa7, 0xd9, 0x4b, 0x55, 0x98, 0x54, 0x64, 0x99, 0x99, 0x99, 0x99,
+  0x99, 0x44, 0x99, 0x79, 0xad, 0xaa, 0x8b, 0xb8, 0x5b, 0xa5, 0xe8, 0xcc,
+  0xc9, 0x8a, 0xb8, 0xe9, 0x99, 0x59, 0x56, 0x68, 0x99, 0x79, 0x99, 0x86,
+  0x4a, 0x94, 0xe4, 0x9a, 0x99, 0x76, 0xa6, 0xc8, 0x88, 0x67, 0x68, 0x99,
+};
+
+static const unsigned char widthsOPEN_SANS_SEMIBOLD_8_11PX[48] = {
+  0x33, 0x75, 0x96, 0x38, 0x33, 0x66, 0x43, 0x43, 0x66, 0x66, 0x66, 0x66,
+  0x66, 0x33, 0x66, 0x56, 0x7a, 0x77, 0x68, 0x86, 0x38, 0x74, 0xa6, 0x99,
+  0x97, 0x67, 0x86, 0xa7, 0x77, 0x46, 0x44, 0x56, 0x67, 0x57, 0x67, 0x65,
+  0x37, 0x64, 0xb3, 0x77, 0x77, 0x55, 0x74, 0x96, 0x66, 0x45, 0x46, 0x76,
+};
+
+static const unsigned char widthsOPEN_SANS_REGULAR_10_13PX[48] = {
+  0x33, 0x85, 0xb7, 0x39, 0x44, 0x77, 0x43, 0x53, 0x77, 0x77, 0x77, 0x77,
+  0x77, 0x33, 0x77, 0x67, 0x8c, 0x88, 0x79, 0x97, 0x4a, 0x85, 0xc7, 0xaa,
+  0xa8, 0x78, 0x97, 0xc8, 0x78, 0x47, 0x45, 0x67, 0x78, 0x68, 0x78, 0x75,
+  0x38, 0x74, 0xc3, 0x88, 0x88, 0x65, 0x85, 0xa7, 0x77, 0x56, 0x57, 0x87,
+};
+
+static const unsigned char widthsOPEN_SANS_REGULAR_11_14PX[48] = {
+  0x44, 0xa6, 0xc9, 0x3b, 0x44, 0x98, 0x54, 0x64, 0x99, 0x99, 0x99, 0x99,
+  0x99, 0x44, 0x99, 0x69, 0xad, 0x9a, 0x8b, 0xb8, 0x4b, 0x95, 0xe8, 0xcb,
+  0xc9, 0x89, 0xb8, 0xe9, 0x89, 0x59, 0x56, 0x78, 0x89, 0x79, 0x89, 0x86,
+  0x49, 0x84, 0xe4, 0x99, 0x99, 0x76, 0x95, 0xc8, 0x88, 0x67, 0x68, 0x99,
+};
+
+static const unsigned char widthsOPEN_SANS_REGULAR_13_18PX[6] = {
+  0x55, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+};
+
+static const unsigned char widthsOPEN_SANS_REGULAR_22_30PX[12] = {
+  0x08, 0x08, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+};
+
+static const unsigned char widthsOPEN_SANS_REGULAR_8_11PX[48] = {
+  0x33, 0x74, 0x96, 0x28, 0x33, 0x66, 0x43, 0x43, 0x66, 0x66, 0x66, 0x66,
+  0x66, 0x33, 0x66, 0x56, 0x7a, 0x77, 0x68, 0x86, 0x38, 0x73, 0xa6, 0x98,
+  0x97, 0x67, 0x86, 0xa7, 0x66, 0x46, 0x44, 0x56, 0x66, 0x57, 0x67, 0x65,
+  0x37, 0x63, 0xa3, 0x77, 0x77, 0x54, 0x74, 0x96, 0x66, 0x45, 0x46, 0x76,
+};
+
+static const unsigned char widthsOPEN_SANS_SEMIBOLD_13_18PX[6] = {
+  0x55, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+};
+
+static const unsigned char widthsSYMBOLS_0[7] = {
+  0x14, 0x0a, 0x09, 0x07, 0x06, 0x10, 0x10,
+};
+
+static const unsigned char widthsSYMBOLS_1[1] = {
+  0x01,
+};
+
+const bagl_font_widths_t C_bagl_font_widths[BAGL_FONT_LAST] = {
+  [BAGL_FONT_LUCIDA_CONSOLE_8PX] = { 0x0020, 0x00df, 4, widthsLUCIDA_CONSOLE_8 },
+  [BAGL_FONT_OPEN_SANS_EXTRABOLD_11px] = { 0x0020, 0x007f, 4, widthsOPEN_SANS_EXTRABOLD_11PX },
+  [BAGL_FONT_OPEN_SANS_LIGHT_16px] = { 0x0020, 0x007f, 4, widthsOPEN_SANS_LIGHT_16PX },
+  [BAGL_FONT_OPEN_SANS_REGULAR_11px] = { 0x0020, 0x007f, 4, widthsOPEN_SANS_REGULAR_11PX },
+  [BAGL_FONT_OPEN_SANS_LIGHT_16_22PX] = { 0x0020, 0x007f, 8, widthsOPEN_SANS_LIGHT_16_22PX },
+  [BAGL_FONT_OPEN_SANS_SEMIBOLD_10_13PX] = { 0x0020, 0x007f, 4, widthsOPEN_SANS_SEMIBOLD_10_13PX },
+  [BAGL_FONT_OPEN_SANS_SEMIBOLD_11_16PX] = { 0x0020, 0x007f, 4, widthsOPEN_SANS_SEMIBOLD_11_16PX },
+  [BAGL_FONT_OPEN_SANS_SEMIBOLD_8_11PX] = { 0x0020, 0x007f, 4, widthsOPEN_SANS_SEMIBOLD_8_11PX },
+  [BAGL_FONT_OPEN_SANS_REGULAR_10_13PX] = { 0x0020, 0x007f, 4, widthsOPEN_SANS_REGULAR_10_13PX },
+  [BAGL_FONT_OPEN_SANS_REGULAR_11_14PX] = { 0x0020, 0x007f, 4, widthsOPEN_SANS_REGULAR_11_14PX },
+  [BAGL_FONT_OPEN_SANS_REGULAR_13_18PX] = { 0x002e, 0x0039, 4, widthsOPEN_SANS_REGULAR_13_18PX },
+  [BAGL_FONT_OPEN_SANS_REGULAR_22_30PX] = { 0x002e, 0x0039, 8, widthsOPEN_SANS_REGULAR_22_30PX },
+  [BAGL_FONT_OPEN_SANS_REGULAR_8_11PX] = { 0x0020, 0x007f, 4, widthsOPEN_SANS_REGULAR_8_11PX },
+  [BAGL_FONT_OPEN_SANS_SEMIBOLD_13_18PX] = { 0x002e, 0x0039, 4, widthsOPEN_SANS_SEMIBOLD_13_18PX },
+  [BAGL_FONT_SYMBOLS_0] = { 0x0000, 0x0006, 8, widthsSYMBOLS_0 },
+  [BAGL_FONT_SYMBOLS_1] = { 0x0000, 0x0000, 4, widthsSYMBOLS_1 },
+};
+
+#endif // HAVE_BAGL
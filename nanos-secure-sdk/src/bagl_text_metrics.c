@@ -0,0 +1,103 @@
+/*******************************************************************************
+*   Ledger Nano S - Secure firmware
+*   (c) 2021 Ledger
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+#include "bagl.h"
+#include "os_helpers.h"
+#include "os_pic.h"
+#include "string.h"
+
+#ifdef HAVE_BAGL
+
+// The widths come from the tables generated by fontwidths.py instead of the
+// fonts themselves, which are not embedded in Nano S applications (the MCU
+// draws the text).
+
+static unsigned int bagl_char_width(const bagl_font_widths_t* font, unsigned int ch) {
+  const unsigned char* widths;
+  if (font->widths == NULL || ch < font->first_char || ch > font->last_char) {
+    return 0;
+  }
+  widths = (const unsigned char*)PIC(font->widths);
+  ch -= font->first_char;
+  if (font->bits_per_width == 8) {
+    return widths[ch];
+  }
+  return (widths[ch/2] >> ((ch&1)*4)) & 0x0F;
+}
+
+static unsigned int is_word_delim(unsigned char c) {
+  return c == ' ' || c == '\t' || c == '-' || c == '_';
+}
+
+void bagl_compute_text_metrics(unsigned short font_id, unsigned short width, const void* text, unsigned short text_length, unsigned char text_encoding, bagl_text_metrics_t* metrics) {
+  const unsigned char* str = (const unsigned char*)text;
+  const bagl_font_widths_t* font;
+  unsigned int xx = 0;
+  unsigned int i;
+
+  // TODO support other encoding than ascii ISO8859 Latin
+  UNUSED(text_encoding);
+
+  memset(metrics, 0, sizeof(bagl_text_metrics_t));
+  font_id &= BAGL_FONT_ID_MASK;
+  if (font_id >= BAGL_FONT_LAST || C_bagl_font_widths[font_id].widths == NULL) {
+    return;
+  }
+  font = &C_bagl_font_widths[font_id];
+
+  for (i = 0; i < text_length; i++) {
+    unsigned int ch = str[i];
+    unsigned int ch_width = 0;
+    unsigned int glyph = 0;
+
+    if (ch >= font->first_char && ch <= font->last_char) {
+      ch_width = bagl_char_width(font, ch);
+      glyph = 1;
+    }
+    // only proceed the first line width, not the whole paragraph
+    else if (ch == '\n' || ch == '\r') {
+      metrics->line_break = 1;
+      break;
+    }
+    // else use the low bits as an extra spacing value
+    else if (ch >= 0xC0) {
+      ch_width = ch&0x3F;
+    }
+    else if (ch >= 0x80) {
+      const bagl_font_widths_t* symbols = &C_bagl_font_widths[(ch&0x20)?BAGL_FONT_SYMBOLS_1:BAGL_FONT_SYMBOLS_0];
+      ch_width = bagl_char_width(symbols, symbols->first_char + (ch & 0x1F));
+      glyph = symbols->widths != NULL;
+    }
+
+    // the line is full
+    if (width > 0 && xx + ch_width > width) {
+      break;
+    }
+    xx += ch_width;
+    metrics->glyph_count += glyph;
+
+    if (is_word_delim(ch)) {
+      metrics->last_delim = i;
+      metrics->last_delim_width = xx - ch_width;
+    }
+  }
+
+  metrics->width = xx;
+  metrics->length = i;
+}
+
+#endif // HAVE_BAGL
@@ -99,9 +99,17 @@ volatile unsigned int   G_io_usb_hid_remaining_length;
 volatile unsigned int   G_io_usb_hid_sequence_number;
 volatile unsigned char* G_io_usb_hid_current_buffer;
 
+static io_usb_hid_chunk_callback_t G_io_usb_hid_chunk_callback;
+static void* G_io_usb_hid_chunk_callback_ctx;
+
+void io_usb_hid_set_chunk_callback(io_usb_hid_chunk_callback_t callback, void *ctx) {
+  G_io_usb_hid_chunk_callback = callback;
+  G_io_usb_hid_chunk_callback_ctx = ctx;
+}
+
 io_usb_hid_receive_status_t io_usb_hid_receive (io_send_t sndfct, unsigned char* buffer, unsigned short l, apdu_buffer_t * apdu_buffer) {
   uint8_t * apdu_buf;
-  uint16_t * apdu_buf_len;
+  uint16_t apdu_buf_len;
 #ifndef HAVE_LOCAL_APDU_BUFFER
   if (apdu_buffer == NULL) {
     apdu_buf = G_io_apdu_buffer;
@@ -174,6 +182,12 @@ io_usb_hid_receive_status_t io_usb_hid_receive (io_send_t sndfct, unsigned char*
       // append content
       memmove((void*)G_io_usb_hid_current_buffer, G_io_usb_ep_buffer+5, l);
     }
+    // stream the chunk while the next one is in flight
+    if (G_io_usb_hid_chunk_callback) {
+      G_io_usb_hid_chunk_callback(G_io_usb_hid_chunk_callback_ctx,
+                                  (const unsigned char*)G_io_usb_hid_current_buffer, l,
+                                  G_io_usb_hid_total_length - G_io_usb_hid_remaining_length);
+    }
     // factorize (f)
     G_io_usb_hid_current_buffer += l;
     G_io_usb_hid_remaining_length -= l;
@@ -23,6 +23,21 @@
 unsigned int SVC_Call(unsigned int syscall_id, void *parameters);
 unsigned int SVC_cx_call(unsigned int syscall_id, unsigned int * parameters);
 
+#ifdef HAVE_PROFILING
+// Implemented by the application to record the beginning and the end of each
+// cryptographic syscall
+void profiling_cx_call(unsigned int syscall_id, unsigned int begin);
+
+static unsigned int SVC_cx_call_profiled(unsigned int syscall_id, unsigned int * parameters) {
+  profiling_cx_call(syscall_id, 1);
+  unsigned int ret = SVC_cx_call(syscall_id, parameters);
+  profiling_cx_call(syscall_id, 0);
+  return ret;
+}
+
+#define SVC_cx_call SVC_cx_call_profiled
+#endif // HAVE_PROFILING
+
 unsigned int get_api_level(void) {
   unsigned int parameters [2+1];
   parameters[0] = 0;
@@ -37,12 +52,20 @@ void halt ( void ) {
   return;
 }
 
+#ifdef HAVE_NVM_STATS
+// Implemented by the application to record NVM writes statistics
+void nvm_write_hook(void * dst_adr, unsigned int src_len);
+#endif // HAVE_NVM_STATS
+
 void nvm_write ( void * dst_adr, void * src_adr, unsigned int src_len ) {
   unsigned int parameters [2+3];
   parameters[0] = (unsigned int)dst_adr;
   parameters[1] = (unsigned int)src_adr;
   parameters[2] = (unsigned int)src_len;
   SVC_Call(SYSCALL_nvm_write_ID_IN, parameters);
+#ifdef HAVE_NVM_STATS
+  nvm_write_hook(dst_adr, src_len);
+#endif // HAVE_NVM_STATS
   return;
 }
 
@@ -7,16 +7,16 @@ pub struct ButtonsState {
 
 impl Default for ButtonsState {
     fn default() -> Self {
-        ButtonsState {
-            button_mask: 0,
-            cmd_buffer: [0u8; 4],
-        }
+        ButtonsState::new()
     }
 }
 
 impl ButtonsState {
-    pub fn new() -> ButtonsState {
-        ButtonsState::default()
+    pub const fn new() -> ButtonsState {
+        ButtonsState {
+            button_mask: 0,
+            cmd_buffer: [0u8; 4],
+        }
     }
 }
 
@@ -51,3 +51,41 @@ pub fn get_button_event(buttons: &mut ButtonsState, new: u8) -> Option<ButtonEve
         _ => None,
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    #[cfg(not(feature = "host"))]
+    use crate::assert_eq_err as assert_eq;
+    #[cfg(not(feature = "host"))]
+    use crate::TestType;
+    #[cfg(not(feature = "host"))]
+    use testmacro::test_item as test;
+
+    fn event_id(event: Option<ButtonEvent>) -> u8 {
+        match event {
+            None => 0,
+            Some(ButtonEvent::LeftButtonPress) => 1,
+            Some(ButtonEvent::RightButtonPress) => 2,
+            Some(ButtonEvent::BothButtonsPress) => 3,
+            Some(ButtonEvent::LeftButtonRelease) => 4,
+            Some(ButtonEvent::RightButtonRelease) => 5,
+            Some(ButtonEvent::BothButtonsRelease) => 6,
+        }
+    }
+
+    #[test]
+    fn button_events() {
+        let mut buttons = ButtonsState::new();
+        assert_eq!(event_id(get_button_event(&mut buttons, 1)), 1);
+        assert_eq!(event_id(get_button_event(&mut buttons, 1)), 0);
+        assert_eq!(event_id(get_button_event(&mut buttons, 0)), 4);
+        assert_eq!(event_id(get_button_event(&mut buttons, 2)), 2);
+        assert_eq!(event_id(get_button_event(&mut buttons, 0)), 5);
+        // Left, then both, released together
+        assert_eq!(event_id(get_button_event(&mut buttons, 1)), 1);
+        assert_eq!(event_id(get_button_event(&mut buttons, 3)), 3);
+        assert_eq!(event_id(get_button_event(&mut buttons, 0)), 6);
+        assert_eq!(buttons.button_mask, 0);
+    }
+}
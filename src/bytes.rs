@@ -0,0 +1,18 @@
+//! Byte array helpers shared by the cryptographic modules
+
+/// Fixed-size byte array, such as a digest, a key or a signature
+pub trait FixedBytes: AsRef<[u8]> + AsMut<[u8]> + Copy {
+    /// Array filled with zeros
+    const ZERO: Self;
+}
+
+impl<const N: usize> FixedBytes for [u8; N] {
+    const ZERO: Self = [0; N];
+}
+
+/// Overwrites `buf` with zeros, without the writes being optimized out.
+pub(crate) fn zeroize(buf: &mut [u8]) {
+    for b in buf.iter_mut() {
+        unsafe { core::ptr::write_volatile(b, 0) };
+    }
+}
@@ -1,6 +1,10 @@
 use crate::bindings::*;
-use crate::io::SyscallError;
+use crate::bytes::{zeroize, FixedBytes};
+use crate::io::{Comm, SyscallError};
+use core::marker::PhantomData;
+use core::ops::Range;
 
+#[derive(Copy, Clone, PartialEq)]
 #[repr(u8)]
 pub enum CurvesId {
     Secp256k1 = CX_CURVE_SECP256K1,
@@ -60,6 +64,410 @@ pub fn ec_get_pubkey(
     }
 }
 
+/// Encoding of a public key, see [`write_pubkey`]
+pub trait PubKeyFormat {
+    /// Length of the encoded key
+    const LEN: usize;
+
+    /// Encodes the uncompressed point `w` (`04 || x || y`) into `out`, which
+    /// is exactly `LEN` bytes long.
+    fn encode(w: &[u8; 65], out: &mut [u8]);
+}
+
+/// SEC1 compressed point: `02 || x` or `03 || x` depending on the parity of y
+pub struct Compressed;
+
+/// SEC1 uncompressed point: `04 || x || y`
+pub struct Uncompressed;
+
+/// X coordinate only, as used by BIP340 Schnorr signatures
+pub struct XOnly;
+
+impl PubKeyFormat for Compressed {
+    const LEN: usize = 33;
+
+    fn encode(w: &[u8; 65], out: &mut [u8]) {
+        out[0] = 0x02 | (w[64] & 1);
+        out[1..].copy_from_slice(&w[1..33]);
+    }
+}
+
+impl PubKeyFormat for Uncompressed {
+    const LEN: usize = 65;
+
+    fn encode(w: &[u8; 65], out: &mut [u8]) {
+        out.copy_from_slice(w);
+    }
+}
+
+impl PubKeyFormat for XOnly {
+    const LEN: usize = 32;
+
+    fn encode(w: &[u8; 65], out: &mut [u8]) {
+        out.copy_from_slice(&w[1..33]);
+    }
+}
+
+/// Public key encoded with the format `F`, borrowed from the buffer it has
+/// been written to by [`write_pubkey`].
+pub struct PublicKey<'a, F: PubKeyFormat> {
+    bytes: &'a [u8],
+    format: PhantomData<F>,
+}
+
+impl<'a, F: PubKeyFormat> PublicKey<'a, F> {
+    /// Returns the encoded public key.
+    pub fn as_bytes(&self) -> &'a [u8] {
+        self.bytes
+    }
+}
+
+/// Computes the public key of `privkey`, and writes it with the format `F`
+/// at the beginning of `out`.
+///
+/// Unlike [`PrivateKey::public_key`], the point is not returned as a
+/// `cx_ecfp_public_key_t` to be re-encoded by the caller: `out` can directly
+/// be the response buffer. The formats are SEC1 encodings, so only
+/// Weierstrass curves are supported.
+///
+/// # Examples
+///
+/// ```
+/// let mut k = PrivateKey::<Secp256k1>::derive(&path)?;
+/// let pubkey = write_pubkey::<_, Compressed>(&mut k, &mut buf)?;
+/// assert_eq!(pubkey.as_bytes().len(), 33);
+/// ```
+pub fn write_pubkey<'a, C: WeierstrassCurve, F: PubKeyFormat>(
+    privkey: &mut PrivateKey<C>,
+    out: &'a mut [u8],
+) -> Result<PublicKey<'a, F>, SyscallError> {
+    if out.len() < F::LEN {
+        return Err(SyscallError::Overflow);
+    }
+    let w = privkey.public_key()?;
+    F::encode(&w.W, &mut out[..F::LEN]);
+    Ok(PublicKey {
+        bytes: &out[..F::LEN],
+        format: PhantomData,
+    })
+}
+
+/// Computes the public key of `privkey`, and appends it with the format `F`
+/// to the response of `comm`.
+///
+/// Fails with `Overflow` if the key does not fit in the APDU buffer, room
+/// being kept for the status word.
+pub fn append_pubkey<C: WeierstrassCurve, F: PubKeyFormat, const N: usize>(
+    comm: &mut Comm<N>,
+    privkey: &mut PrivateKey<C>,
+) -> Result<(), SyscallError> {
+    // Keep room for the status word
+    let end = comm.capacity() - 2;
+    let tx = comm.tx.min(end);
+    let len = write_pubkey::<C, F>(privkey, &mut comm.apdu_buffer[tx..end])?
+        .as_bytes()
+        .len();
+    comm.tx += len;
+    Ok(())
+}
+
+/// Maximum depth of the parent nodes kept by [`Bip32Cache`]
+const BIP32_CACHE_MAX_DEPTH: usize = 10;
+
+/// Parent node kept by [`Bip32Cache`]. Not `Copy`, so that the private key
+/// it holds cannot be duplicated implicitly.
+struct Bip32CacheEntry {
+    valid: bool,
+    depth: usize,
+    path: [u32; BIP32_CACHE_MAX_DEPTH],
+    privkey: [u8; 32],
+    pubkey: [u8; Compressed::LEN],
+    chain: [u8; 32],
+}
+
+impl Bip32CacheEntry {
+    const EMPTY: Bip32CacheEntry = Bip32CacheEntry {
+        valid: false,
+        depth: 0,
+        path: [0; BIP32_CACHE_MAX_DEPTH],
+        privkey: [0; 32],
+        pubkey: [0; Compressed::LEN],
+        chain: [0; 32],
+    };
+
+    fn matches(&self, parent: &[u32]) -> bool {
+        self.valid && &self.path[..self.depth] == parent
+    }
+
+    fn clear(&mut self) {
+        zeroize(&mut self.privkey);
+        zeroize(&mut self.chain);
+        *self = Self::EMPTY;
+    }
+}
+
+/// RAM cache of BIP32 parent nodes on the curve `C`, to derive non-hardened
+/// children without deriving the whole path from the seed.
+///
+/// When deriving a path whose last index is not hardened, the parent node
+/// (private key, public key and chain code) is derived once by the OS, then
+/// kept in the cache. Siblings, such as consecutive addresses
+/// `m/44'/60'/0'/0/i`, are then derived locally with a single HMAC-SHA512
+/// and a modular addition (BIP32 CKDpriv), which is much faster than a full
+/// derivation. Up to `E` parent nodes are kept, the oldest one being evicted
+/// first.
+///
+/// Only the curves whose OS derivation is plain BIP32 are supported (see
+/// [`Bip32Curve`]). The cache holds private keys: it
+/// is zeroized on drop, and [`clear`](Bip32Cache::clear) should be called as
+/// soon as it is not needed anymore.
+///
+/// # Examples
+///
+/// ```
+/// let mut cache = Bip32Cache::<Secp256k1, 1>::new();
+/// for i in 0..20 {
+///     let path = [0x8000002c, 0x8000003c, 0x80000000, 0, i];
+///     let k = cache.derive(&path)?;
+///     ...
+/// }
+/// cache.clear();
+/// ```
+pub struct Bip32Cache<C, const E: usize> {
+    entries: [Bip32CacheEntry; E],
+    next: usize,
+    curve: PhantomData<C>,
+}
+
+impl<C: Bip32Curve, const E: usize> Default for Bip32Cache<C, E> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<C, const E: usize> Bip32Cache<C, E> {
+    pub const fn new() -> Self {
+        Bip32Cache {
+            entries: [Bip32CacheEntry::EMPTY; E],
+            next: 0,
+            curve: PhantomData,
+        }
+    }
+
+    /// Zeroizes and evicts all the cached nodes.
+    pub fn clear(&mut self) {
+        for entry in self.entries.iter_mut() {
+            entry.clear();
+        }
+        self.next = 0;
+    }
+}
+
+impl<C: Bip32Curve, const E: usize> Bip32Cache<C, E> {
+    /// Derives the private key of `path`, like [`PrivateKey::derive`].
+    pub fn derive(&mut self, path: &[u32]) -> Result<PrivateKey<C>, SyscallError> {
+        let (index, parent) = match path.split_last() {
+            Some((&index, parent))
+                if index & 0x80000000 == 0 && parent.len() <= BIP32_CACHE_MAX_DEPTH =>
+            {
+                (index, parent)
+            }
+            // Hardened children cannot be derived from the parent public key:
+            // no benefit from caching.
+            _ => return PrivateKey::derive(path),
+        };
+
+        let entry = match self.entries.iter().position(|e| e.matches(parent)) {
+            Some(i) => &self.entries[i],
+            None => {
+                // The slot is only consumed once filled: after a failure,
+                // the same slot is reused by the next derivation.
+                let i = self.next;
+                self.entries[i].clear();
+                Self::fill_entry(&mut self.entries[i], parent)?;
+                self.next = (self.next + 1) % E;
+                &self.entries[i]
+            }
+        };
+
+        let mut child = [0u8; 32];
+        let key = match ckd_priv::<C>(entry, index, &mut child) {
+            Ok(()) => PrivateKey::from_raw(&child),
+            // The child key is invalid for this index (probability below
+            // 2^-127), or could not be computed: let the OS handle this
+            // case as specified by BIP32.
+            Err(_) => PrivateKey::derive(path),
+        };
+        zeroize(&mut child);
+        key
+    }
+
+    /// Derives the `parent` node with the OS and stores it in `entry`. The
+    /// entry is zeroized if the node cannot be stored.
+    fn fill_entry(entry: &mut Bip32CacheEntry, parent: &[u32]) -> Result<(), SyscallError> {
+        let mut privkey = [0u8; 64];
+        unsafe {
+            os_perso_derive_node_bip32(
+                C::ID,
+                parent.as_ptr(),
+                parent.len() as u32,
+                privkey.as_mut_ptr(),
+                entry.chain.as_mut_ptr(),
+            )
+        };
+        entry.privkey.copy_from_slice(&privkey[..32]);
+        zeroize(&mut privkey);
+
+        let res = PrivateKey::<C>::from_raw(&entry.privkey)
+            .and_then(|mut k| write_pubkey::<C, Compressed>(&mut k, &mut entry.pubkey).map(|_| ()));
+        if let Err(e) = res {
+            entry.clear();
+            return Err(e);
+        }
+
+        entry.depth = parent.len();
+        entry.path[..parent.len()].copy_from_slice(parent);
+        entry.valid = true;
+        Ok(())
+    }
+}
+
+impl<C, const E: usize> Drop for Bip32Cache<C, E> {
+    fn drop(&mut self) {
+        self.clear();
+    }
+}
+
+/// BIP32 CKDpriv for a non-hardened `index`, from a cached parent node.
+fn ckd_priv<C: Bip32Curve>(
+    parent: &Bip32CacheEntry,
+    index: u32,
+    key: &mut [u8; 32],
+) -> Result<(), SyscallError> {
+    let mut data = [0u8; 37];
+    data[..33].copy_from_slice(&parent.pubkey);
+    data[33..].copy_from_slice(&index.to_be_bytes());
+    let mut i = [0u8; 64];
+    let mac_len = unsafe {
+        cx_hmac_sha512(
+            parent.chain.as_ptr(),
+            parent.chain.len() as u32,
+            data.as_ptr(),
+            data.len() as u32,
+            i.as_mut_ptr(),
+            i.len() as u32,
+        )
+    };
+    if mac_len != i.len() as u32 {
+        zeroize(&mut i);
+        return Err(SyscallError::Unspecified);
+    }
+
+    let mut order = [0u8; 32];
+    let mut diff = 0;
+    let mut child = [0u8; 32];
+    let res = unsafe {
+        let mut err = cx_ecdomain_parameter(
+            C::ID,
+            CX_CURVE_PARAM_Order,
+            order.as_mut_ptr(),
+            order.len() as u32,
+        );
+        if err == CX_OK {
+            err = cx_math_cmp_no_throw(i.as_ptr(), order.as_ptr(), 32, &mut diff);
+        }
+        if err == CX_OK && diff < 0 {
+            err = cx_math_addm_no_throw(
+                child.as_mut_ptr(),
+                i.as_ptr(),
+                parent.privkey.as_ptr(),
+                order.as_ptr(),
+                32,
+            );
+        }
+        match err {
+            CX_OK if diff >= 0 || child.iter().all(|&b| b == 0) => {
+                Err(SyscallError::InvalidParameter)
+            }
+            CX_OK => Ok(()),
+            err => Err(err.into()),
+        }
+    };
+    if res.is_ok() {
+        key[..32].copy_from_slice(&child);
+    }
+    zeroize(&mut i);
+    zeroize(&mut child);
+    res
+}
+
+/// Size of a compressed public key, as written by [`derive_pubkeys`]
+pub const COMPRESSED_PUBKEY_LEN: usize = Compressed::LEN;
+
+/// Derives the public keys of the children `range` of the `path_prefix` node,
+/// and writes them compressed and concatenated into `out`.
+///
+/// The parent node is derived only once, and children are then stepped
+/// through from it (see [`Bip32Cache`]), which is much faster than deriving
+/// each full path. Derivation stops when `out` is full.
+///
+/// Returns the number of public keys written.
+///
+/// # Examples
+///
+/// ```
+/// // First 20 receive addresses of an account
+/// let mut pubkeys = [0u8; 20 * COMPRESSED_PUBKEY_LEN];
+/// let prefix = make_bip32_path::<4>(b"m/44'/60'/0'/0");
+/// derive_pubkeys::<Secp256k1>(&prefix, 0..20, &mut pubkeys)?;
+/// ```
+pub fn derive_pubkeys<C: Bip32Curve>(
+    path_prefix: &[u32],
+    range: Range<u32>,
+    out: &mut [u8],
+) -> Result<usize, SyscallError> {
+    if path_prefix.len() >= BIP32_CACHE_MAX_DEPTH {
+        return Err(SyscallError::InvalidParameter);
+    }
+    let mut path = [0u32; BIP32_CACHE_MAX_DEPTH];
+    path[..path_prefix.len()].copy_from_slice(path_prefix);
+    let path = &mut path[..path_prefix.len() + 1];
+
+    let mut cache = Bip32Cache::<C, 1>::new();
+    let mut count = 0;
+    for (index, pubkey) in range.zip(out.chunks_exact_mut(COMPRESSED_PUBKEY_LEN)) {
+        path[path_prefix.len()] = index;
+        let mut k = cache.derive(path)?;
+        write_pubkey::<C, Compressed>(&mut k, pubkey)?;
+        count += 1;
+    }
+    Ok(count)
+}
+
+/// Derives the public keys of the children `range` of the `path_prefix`
+/// node with [`derive_pubkeys`], and appends as many of them as the APDU
+/// buffer of `comm` allows to the response.
+///
+/// Returns the index of the first child which has not been appended, which is
+/// `range.end` if all the keys fit. The host can then request the remaining
+/// keys with a following command.
+pub fn append_pubkeys<C: Bip32Curve, const N: usize>(
+    comm: &mut Comm<N>,
+    path_prefix: &[u32],
+    range: Range<u32>,
+) -> Result<u32, SyscallError> {
+    let start = range.start;
+    // Keep room for the status word
+    let end = comm.capacity() - 2;
+    let count = derive_pubkeys::<C>(
+        path_prefix,
+        range,
+        &mut comm.apdu_buffer[comm.tx.min(end)..end],
+    )?;
+    comm.tx += count * COMPRESSED_PUBKEY_LEN;
+    Ok(start + count as u32)
+}
+
 pub type DerEncodedEcdsaSignature = [u8; 73];
 /// Wrapper for 'cx_ecdsa_sign'
 pub fn ecdsa_sign(
@@ -103,6 +511,524 @@ pub fn ecdsa_verify(pubkey: &cx_ecfp_public_key_t, sig: &[u8], hash: &[u8]) -> b
     }
 }
 
+/// Elliptic curve supported by the cryptographic library.
+///
+/// Curves are zero-sized types used as type parameters, for instance by
+/// [`PrivateKey`]. Sizes are known at compile time, and operations are only
+/// available on the curves supporting them: ECDSA requires a
+/// [`WeierstrassCurve`], so signing with ECDSA on Ed25519 does not compile.
+/// Code is only generated for the curves an application actually uses.
+pub trait Curve {
+    /// Curve identifier in the cryptographic library
+    const ID: cx_curve_t;
+
+    /// Fixed-size signature: `r || s` for ECDSA, `R || S` for EdDSA.
+    type Signature: FixedBytes;
+}
+
+/// Short Weierstrass curve, supporting ECDSA
+pub trait WeierstrassCurve: Curve {}
+
+/// Twisted Edwards curve, supporting EdDSA
+pub trait EdwardsCurve: Curve {}
+
+/// Weierstrass curve on which the OS derives BIP32 children with the
+/// standard CKDpriv, so that [`Bip32Cache`] derives the same keys.
+///
+/// Not implemented for [`Stark256`], whose derivation by the OS differs.
+pub trait Bip32Curve: WeierstrassCurve {}
+
+/// SECG secp256k1 curve
+pub struct Secp256k1;
+/// SECG secp256r1 (NIST P-256) curve
+pub struct Secp256r1;
+/// Ed25519 curve
+pub struct Ed25519;
+/// STARK curve
+pub struct Stark256;
+
+impl Curve for Secp256k1 {
+    const ID: cx_curve_t = CX_CURVE_SECP256K1;
+    type Signature = [u8; 64];
+}
+impl WeierstrassCurve for Secp256k1 {}
+impl Bip32Curve for Secp256k1 {}
+
+impl Curve for Secp256r1 {
+    const ID: cx_curve_t = CX_CURVE_SECP256R1;
+    type Signature = [u8; 64];
+}
+impl WeierstrassCurve for Secp256r1 {}
+impl Bip32Curve for Secp256r1 {}
+
+impl Curve for Stark256 {
+    const ID: cx_curve_t = CX_CURVE_Stark256;
+    type Signature = [u8; 64];
+}
+impl WeierstrassCurve for Stark256 {}
+
+impl Curve for Ed25519 {
+    const ID: cx_curve_t = CX_CURVE_Ed25519;
+    type Signature = [u8; 64];
+}
+impl EdwardsCurve for Ed25519 {}
+
+/// Maximum length of a DER encoded ECDSA signature on a 256-bit curve
+const ECDSA_DER_MAX_LEN: usize = 72;
+
+/// Converts a DER encoded ECDSA signature to fixed-size `r || s`.
+fn ecdsa_der_to_rs(der: &[u8], out: &mut [u8]) -> Option<()> {
+    let half = out.len() / 2;
+    let int = |der: &[u8], out: &mut [u8]| -> Option<usize> {
+        if der.len() < 2 || der[0] != 0x02 {
+            return None;
+        }
+        let len = der[1] as usize;
+        let value = der.get(2..2 + len)?;
+        // Strip the sign byte
+        let start = value.iter().position(|&b| b != 0).unwrap_or(len);
+        let value = &value[start..];
+        if value.len() > out.len() {
+            return None;
+        }
+        let pad = out.len() - value.len();
+        out[..pad].iter_mut().for_each(|b| *b = 0);
+        out[pad..].copy_from_slice(value);
+        Some(2 + len)
+    };
+    if der.len() < 2 || der[0] != 0x30 {
+        return None;
+    }
+    let (r, s) = out.split_at_mut(half);
+    let r_len = int(&der[2..], r)?;
+    int(&der[2 + r_len..], s)?;
+    Some(())
+}
+
+/// Converts a fixed-size `r || s` ECDSA signature to DER into `out`, and
+/// returns the encoded length.
+fn ecdsa_rs_to_der(rs: &[u8], out: &mut [u8; ECDSA_DER_MAX_LEN]) -> usize {
+    let mut pos = 2;
+    for int in rs.chunks(rs.len() / 2) {
+        // Minimal encoding, with a sign byte if the high bit is set
+        let start = int.iter().position(|&b| b != 0).unwrap_or(int.len() - 1);
+        let int = &int[start..];
+        let sign = (int[0] & 0x80 != 0) as usize;
+        out[pos] = 0x02;
+        out[pos + 1] = (int.len() + sign) as u8;
+        out[pos + 2] = 0;
+        out[pos + 2 + sign..pos + 2 + sign + int.len()].copy_from_slice(int);
+        pos += 2 + sign + int.len();
+    }
+    out[0] = 0x30;
+    out[1] = (pos - 2) as u8;
+    pos
+}
+
+/// Private key on the curve `C`. Zeroized on drop.
+///
+/// # Examples
+///
+/// ```
+/// let path: [u32; 5] = make_bip32_path(b"m/44'/535348'/0'/0/0");
+/// let mut k = PrivateKey::<Secp256k1>::derive(&path)?;
+/// let (sig, parity) = k.ecdsa_sign(&hash)?;
+/// let pubkey = k.public_key()?;
+/// assert!(ecdsa_verify_rs::<Secp256k1>(&pubkey, &sig, &hash));
+/// ```
+pub struct PrivateKey<C: Curve> {
+    key: cx_ecfp_private_key_t,
+    curve: PhantomData<C>,
+}
+
+impl<C: Curve> PrivateKey<C> {
+    /// Derives the private key at BIP32 `path`.
+    pub fn derive(path: &[u32]) -> Result<Self, SyscallError> {
+        let mut raw_key = [0u8; 64];
+        unsafe {
+            os_perso_derive_node_bip32(
+                C::ID,
+                path.as_ptr(),
+                path.len() as u32,
+                raw_key.as_mut_ptr(),
+                core::ptr::null_mut(),
+            )
+        };
+        let key = Self::from_raw(&raw_key[..32]);
+        zeroize(&mut raw_key);
+        key
+    }
+
+    /// Creates a private key from its raw value.
+    pub fn from_raw(raw_key: &[u8]) -> Result<Self, SyscallError> {
+        let mut key = cx_ecfp_private_key_t::default();
+        let err = unsafe {
+            cx_ecfp_init_private_key_no_throw(
+                C::ID,
+                raw_key.as_ptr(),
+                raw_key.len() as u32,
+                &mut key,
+            )
+        };
+        if err != 0 {
+            Err(err.into())
+        } else {
+            Ok(PrivateKey {
+                key,
+                curve: PhantomData,
+            })
+        }
+    }
+
+    /// Computes the public key.
+    pub fn public_key(&mut self) -> Result<cx_ecfp_public_key_t, SyscallError> {
+        let mut pubkey = cx_ecfp_public_key_t::default();
+        let err =
+            unsafe { cx_ecfp_generate_pair_no_throw(C::ID, &mut pubkey, &mut self.key, true) };
+        if err != 0 {
+            Err(err.into())
+        } else {
+            Ok(pubkey)
+        }
+    }
+
+    /// Returns the underlying key, to be used with the cryptographic library.
+    pub fn as_raw(&self) -> &cx_ecfp_private_key_t {
+        &self.key
+    }
+}
+
+impl<C: WeierstrassCurve> PrivateKey<C> {
+    /// Signs `hash` with deterministic ECDSA (RFC 6979, with SHA-256).
+    ///
+    /// Returns the `r || s` signature and the parity information bits
+    /// (`CX_ECCINFO_PARITY_ODD`, `CX_ECCINFO_xGTn`), used for public key
+    /// recovery.
+    pub fn ecdsa_sign(&self, hash: &[u8]) -> Result<(C::Signature, u32), SyscallError> {
+        let mut der = [0u8; ECDSA_DER_MAX_LEN];
+        let mut der_len = der.len() as u32;
+        let mut info = 0;
+        let err = unsafe {
+            cx_ecdsa_sign_no_throw(
+                &self.key,
+                CX_RND_RFC6979 | CX_LAST,
+                CX_SHA256,
+                hash.as_ptr(),
+                hash.len() as u32,
+                der.as_mut_ptr(),
+                &mut der_len,
+                &mut info,
+            )
+        };
+        if err != CX_OK {
+            return Err(err.into());
+        }
+        let mut sig = C::Signature::ZERO;
+        ecdsa_der_to_rs(&der[..der_len as usize], sig.as_mut()).ok_or(SyscallError::Unspecified)?;
+        Ok((sig, info))
+    }
+
+    /// Signs `msg` with EC-Schnorr, using SHA-256 as hash function.
+    ///
+    /// `mode` selects the variant and the nonce generation, for instance
+    /// `CX_ECSCHNORR_BSI03111 | CX_RND_TRNG`. `msg` is usually the digest of
+    /// the message to sign, which can be computed incrementally beforehand.
+    ///
+    /// Returns the `r || s` signature.
+    pub fn schnorr_sign(&self, mode: u32, msg: &[u8]) -> Result<C::Signature, SyscallError> {
+        let mut der = [0u8; ECDSA_DER_MAX_LEN];
+        let mut der_len = der.len() as u32;
+        let err = unsafe {
+            cx_ecschnorr_sign_no_throw(
+                &self.key,
+                mode,
+                CX_SHA256,
+                msg.as_ptr(),
+                msg.len() as u32,
+                der.as_mut_ptr(),
+                &mut der_len,
+            )
+        };
+        if err != CX_OK {
+            return Err(err.into());
+        }
+        let mut sig = C::Signature::ZERO;
+        ecdsa_der_to_rs(&der[..der_len as usize], sig.as_mut()).ok_or(SyscallError::Unspecified)?;
+        Ok(sig)
+    }
+}
+
+impl<C: EdwardsCurve> PrivateKey<C> {
+    /// Signs `msg` with EdDSA (RFC 8032, with SHA-512). The whole message must
+    /// be in memory; see [`eddsa_sign_stream`](PrivateKey::eddsa_sign_stream)
+    /// for larger messages.
+    pub fn eddsa_sign(&self, msg: &[u8]) -> Result<C::Signature, SyscallError> {
+        let mut sig = C::Signature::ZERO;
+        let err = unsafe {
+            cx_eddsa_sign_no_throw(
+                &self.key,
+                CX_SHA512,
+                msg.as_ptr(),
+                msg.len() as u32,
+                sig.as_mut().as_mut_ptr(),
+                sig.as_ref().len() as u32,
+            )
+        };
+        if err != CX_OK {
+            Err(err.into())
+        } else {
+            Ok(sig)
+        }
+    }
+}
+
+/// Message which can be read several times, chunk by chunk, for signature
+/// schemes that need more than one pass over the message.
+///
+/// This allows signing messages which do not fit in RAM, for instance
+/// stored in NVM.
+pub trait ReplayableMessage {
+    /// Calls `f` with each chunk of the message, in order. Every call must
+    /// yield the same message: signers check it, and fail if it does not.
+    fn replay(&mut self, f: &mut dyn FnMut(&[u8]));
+}
+
+impl ReplayableMessage for &[u8] {
+    fn replay(&mut self, f: &mut dyn FnMut(&[u8])) {
+        f(self)
+    }
+}
+
+/// SHA-512 of the concatenation of `prefix` and the replayed `msg`, reduced
+/// modulo `order` and returned big-endian, as EdDSA scalars are.
+///
+/// The SHA-512 of `msg` alone is written into `msg_digest`, so that the
+/// caller can check that each pass saw the same message.
+fn ed25519_hash_to_scalar(
+    prefix: &[&[u8]],
+    msg: &mut dyn ReplayableMessage,
+    order: &[u8; 32],
+    msg_digest: &mut [u8; 64],
+) -> Result<[u8; 32], SyscallError> {
+    let mut ctx = cx_sha512_t::default();
+    let mut msg_ctx = cx_sha512_t::default();
+    let mut digest = [0u8; 64];
+    let mut err = unsafe { cx_sha512_init_no_throw(&mut ctx) };
+    if err == CX_OK {
+        err = unsafe { cx_sha512_init_no_throw(&mut msg_ctx) };
+    }
+    for data in prefix {
+        if err == CX_OK {
+            err = unsafe { cx_hash_update(&mut ctx.header, data.as_ptr(), data.len() as u32) };
+        }
+    }
+    msg.replay(&mut |chunk| {
+        if err == CX_OK {
+            err = unsafe { cx_hash_update(&mut ctx.header, chunk.as_ptr(), chunk.len() as u32) };
+        }
+        if err == CX_OK {
+            err =
+                unsafe { cx_hash_update(&mut msg_ctx.header, chunk.as_ptr(), chunk.len() as u32) };
+        }
+    });
+    if err == CX_OK {
+        err = unsafe { cx_hash_final(&mut ctx.header, digest.as_mut_ptr()) };
+    }
+    if err == CX_OK {
+        err = unsafe { cx_hash_final(&mut msg_ctx.header, msg_digest.as_mut_ptr()) };
+    }
+    // Little-endian digest to big-endian integer
+    digest.reverse();
+    if err == CX_OK {
+        err = unsafe { cx_math_modm_no_throw(digest.as_mut_ptr(), 64, order.as_ptr(), 32) };
+    }
+    let mut scalar = [0u8; 32];
+    scalar.copy_from_slice(&digest[32..]);
+    zeroize(&mut digest);
+    zeroize(&mut ctx.block);
+    match err {
+        CX_OK => Ok(scalar),
+        err => Err(err.into()),
+    }
+}
+
+/// Computes `k.B` and writes its RFC 8032 encoding (y little-endian, with
+/// the parity of x in the top bit) into `out`.
+fn ed25519_scalar_mult_base(k: &[u8; 32], out: &mut [u8]) -> Result<(), SyscallError> {
+    let mut p = [0u8; 65];
+    p[0] = 0x04;
+    let (x, y) = p[1..].split_at_mut(32);
+    let mut err =
+        unsafe { cx_ecdomain_generator(CX_CURVE_Ed25519, x.as_mut_ptr(), y.as_mut_ptr(), 32) };
+    if err == CX_OK {
+        err = unsafe {
+            cx_ecfp_scalar_mult_no_throw(CX_CURVE_Ed25519, p.as_mut_ptr(), k.as_ptr(), 32)
+        };
+    }
+    if err != CX_OK {
+        return Err(err.into());
+    }
+    for (i, b) in out[..32].iter_mut().enumerate() {
+        *b = p[64 - i];
+    }
+    out[31] |= (p[32] & 1) << 7;
+    Ok(())
+}
+
+impl PrivateKey<Ed25519> {
+    /// Signs a message with Ed25519 (RFC 8032), without having it in memory.
+    ///
+    /// Ed25519 hashes the message twice: once to compute the nonce, then
+    /// once with the nonce commitment. `msg` is therefore replayed twice,
+    /// and only one chunk at a time needs to be in RAM.
+    ///
+    /// Releasing two signatures with the same nonce but different messages
+    /// would leak the private key. The message is therefore also hashed on
+    /// its own during both passes, and the signature fails with
+    /// `InvalidChecksum`, without computing S, if the digests differ.
+    pub fn eddsa_sign_stream(
+        &self,
+        msg: &mut dyn ReplayableMessage,
+    ) -> Result<<Ed25519 as Curve>::Signature, SyscallError> {
+        let mut order = [0u8; 32];
+        let err = unsafe {
+            cx_ecdomain_parameter(
+                CX_CURVE_Ed25519,
+                CX_CURVE_PARAM_Order,
+                order.as_mut_ptr(),
+                32,
+            )
+        };
+        if err != CX_OK {
+            return Err(err.into());
+        }
+
+        // Secret scalar a and nonce prefix, from the hash of the seed
+        let mut h = [0u8; 64];
+        let err =
+            unsafe { cx_hash_sha512(self.key.d.as_ptr(), 32, h.as_mut_ptr(), h.len() as u32) };
+        if err != h.len() as u32 {
+            return Err(SyscallError::Unspecified);
+        }
+        let mut a = [0u8; 32];
+        a.copy_from_slice(&h[..32]);
+        a[0] &= 248;
+        a[31] &= 127;
+        a[31] |= 64;
+        a.reverse();
+        let mut sig = [0u8; 64];
+        let mut pubkey = [0u8; 32];
+        let mut r = [0u8; 32];
+        let mut s = [0u8; 32];
+        let res = (|| {
+            let err = unsafe { cx_math_modm_no_throw(a.as_mut_ptr(), 32, order.as_ptr(), 32) };
+            if err != CX_OK {
+                return Err(SyscallError::from(err));
+            }
+            ed25519_scalar_mult_base(&a, &mut pubkey)?;
+
+            // First pass: r = H(prefix || M), R = r.B
+            let mut first = [0u8; 64];
+            r = ed25519_hash_to_scalar(&[&h[32..]], msg, &order, &mut first)?;
+            ed25519_scalar_mult_base(&r, &mut sig[..32])?;
+
+            // Second pass: k = H(R || A || M), S = r + k.a
+            let mut second = [0u8; 64];
+            let k = ed25519_hash_to_scalar(&[&sig[..32], &pubkey], msg, &order, &mut second)?;
+            if first != second {
+                return Err(SyscallError::InvalidChecksum);
+            }
+            let mut err = unsafe {
+                cx_math_multm_no_throw(s.as_mut_ptr(), k.as_ptr(), a.as_ptr(), order.as_ptr(), 32)
+            };
+            if err == CX_OK {
+                err = unsafe {
+                    cx_math_addm_no_throw(
+                        s.as_mut_ptr(),
+                        s.as_ptr(),
+                        r.as_ptr(),
+                        order.as_ptr(),
+                        32,
+                    )
+                };
+            }
+            if err != CX_OK {
+                return Err(SyscallError::from(err));
+            }
+            for (i, b) in sig[32..].iter_mut().enumerate() {
+                *b = s[31 - i];
+            }
+            Ok(())
+        })();
+        zeroize(&mut h);
+        zeroize(&mut a);
+        zeroize(&mut r);
+        zeroize(&mut s);
+        res.map(|_| sig)
+    }
+}
+
+impl<C: Curve> Drop for PrivateKey<C> {
+    fn drop(&mut self) {
+        zeroize(&mut self.key.d);
+    }
+}
+
+/// Verifies a `r || s` ECDSA signature, as returned by
+/// [`PrivateKey::ecdsa_sign`].
+pub fn ecdsa_verify_rs<C: WeierstrassCurve>(
+    pubkey: &cx_ecfp_public_key_t,
+    sig: &C::Signature,
+    hash: &[u8],
+) -> bool {
+    let mut der = [0u8; ECDSA_DER_MAX_LEN];
+    let len = ecdsa_rs_to_der(sig.as_ref(), &mut der);
+    pubkey.curve == C::ID && ecdsa_verify(pubkey, &der[..len], hash)
+}
+
+/// Verifies a `r || s` EC-Schnorr signature, as returned by
+/// [`PrivateKey::schnorr_sign`].
+pub fn schnorr_verify<C: WeierstrassCurve>(
+    pubkey: &cx_ecfp_public_key_t,
+    mode: u32,
+    sig: &C::Signature,
+    msg: &[u8],
+) -> bool {
+    let mut der = [0u8; ECDSA_DER_MAX_LEN];
+    let len = ecdsa_rs_to_der(sig.as_ref(), &mut der);
+    pubkey.curve == C::ID
+        && unsafe {
+            cx_ecschnorr_verify(
+                pubkey,
+                mode,
+                CX_SHA256,
+                msg.as_ptr(),
+                msg.len() as u32,
+                der.as_ptr(),
+                len as u32,
+            )
+        }
+}
+
+/// Verifies an EdDSA signature (RFC 8032, with SHA-512).
+pub fn eddsa_verify<C: EdwardsCurve>(
+    pubkey: &cx_ecfp_public_key_t,
+    sig: &C::Signature,
+    msg: &[u8],
+) -> bool {
+    pubkey.curve == C::ID
+        && unsafe {
+            cx_eddsa_verify_no_throw(
+                pubkey,
+                CX_SHA512,
+                msg.as_ptr(),
+                msg.len() as u32,
+                sig.as_ref().as_ptr(),
+                sig.as_ref().len() as u32,
+            )
+        }
+}
+
 /// Creates at compile time an array from the ASCII values of a correctly
 /// formatted derivation path.
 ///
@@ -201,7 +1127,7 @@ pub const fn make_bip32_path<const N: usize>(bytes: &[u8]) -> [u32; N] {
     path
 }
 
-#[cfg(test)]
+#[cfg(all(test, not(feature = "host")))]
 mod tests {
     use super::*;
     use crate::assert_eq_err as assert_eq;
@@ -253,6 +1179,83 @@ mod tests {
         assert_eq!(verif, true);
     }
 
+    #[test]
+    fn bip32_cache() {
+        // Keys derived from a cached parent node must match the ones derived
+        // from the seed
+        fn check<C: Bip32Curve>() -> Result<(), SyscallError> {
+            let mut cache = Bip32Cache::<C, 1>::new();
+            let mut path = PATH;
+            for i in 0..3 {
+                path[4] = i;
+                let expected = PrivateKey::<C>::derive(&path)?;
+                let key = cache.derive(&path)?;
+                if key.as_raw().d != expected.as_raw().d {
+                    return Err(SyscallError::InvalidState);
+                }
+            }
+            cache.clear();
+            Ok(())
+        }
+        // Every Bip32Curve must be checked here
+        check::<Secp256k1>()?;
+        check::<Secp256r1>()?;
+    }
+
+    #[test]
+    fn derive_pubkeys_batch() {
+        let mut pubkeys = [0u8; 2 * COMPRESSED_PUBKEY_LEN];
+        let count = derive_pubkeys::<Secp256k1>(&PATH[..4], 5..10, &mut pubkeys)?;
+        assert_eq!(count, 2);
+
+        let mut path = PATH;
+        path[4] = 6;
+        let pubkey = PrivateKey::<Secp256k1>::derive(&path)?.public_key()?;
+        assert_eq!(pubkeys[COMPRESSED_PUBKEY_LEN + 1..], pubkey.W[1..33]);
+        assert_eq!(pubkeys[COMPRESSED_PUBKEY_LEN], 0x02 | (pubkey.W[64] & 1));
+    }
+
+    #[test]
+    fn typed_curve_ecdsa() {
+        let hash = [0x5au8; 32];
+        let mut k = PrivateKey::<Secp256r1>::derive(&PATH)?;
+        let (sig, _) = k.ecdsa_sign(&hash)?;
+        let pubkey = k.public_key()?;
+        assert_eq!(ecdsa_verify_rs::<Secp256r1>(&pubkey, &sig, &hash), true);
+    }
+
+    #[test]
+    fn eddsa_stream() {
+        // Streamed signature must match the one-shot one, chunking included
+        let msg = [0xa5u8; 300];
+        let k = PrivateKey::<Ed25519>::derive(&PATH)?;
+        let expected = k.eddsa_sign(&msg)?;
+        let mut chunks = |f: &mut dyn FnMut(&[u8])| msg.chunks(64).for_each(|c| f(c));
+        struct Chunked<'a>(&'a mut dyn FnMut(&mut dyn FnMut(&[u8])));
+        impl ReplayableMessage for Chunked<'_> {
+            fn replay(&mut self, f: &mut dyn FnMut(&[u8])) {
+                (self.0)(f)
+            }
+        }
+        let sig = k.eddsa_sign_stream(&mut Chunked(&mut chunks))?;
+        assert_eq!(sig, expected);
+    }
+
+    #[test]
+    fn eddsa_stream_replay_mismatch() {
+        // A message which changes between the two passes must not be signed
+        struct Changing(u8);
+        impl ReplayableMessage for Changing {
+            fn replay(&mut self, f: &mut dyn FnMut(&[u8])) {
+                self.0 += 1;
+                f(&[self.0; 32])
+            }
+        }
+        let k = PrivateKey::<Ed25519>::derive(&PATH)?;
+        let res = k.eddsa_sign_stream(&mut Changing(0));
+        assert!(matches!(res, Err(SyscallError::InvalidChecksum)));
+    }
+
     #[test]
     fn test_make_bip32_path() {
         {
@@ -273,3 +1276,38 @@ mod tests {
         }
     }
 }
+
+// Tests of the functions which do not rely on cryptographic syscalls, run
+// natively with the `host` feature
+#[cfg(all(test, feature = "host"))]
+mod host_tests {
+    use super::*;
+
+    #[test]
+    fn bip32_path() {
+        const PATH: [u32; 5] = make_bip32_path(b"m/44'/535348'/0'/0/12");
+        assert_eq!(PATH, [0x8000_002c, 0x8008_2b34, 0x8000_0000, 0, 12]);
+    }
+
+    #[test]
+    #[should_panic]
+    fn bip32_path_empty_token() {
+        let _: [u32; 2] = make_bip32_path(b"m/44'//0");
+    }
+
+    #[test]
+    fn ecdsa_der_round_trip() {
+        let mut rs = [0u8; 64];
+        for i in 0..1000u32 {
+            crate::random::rand_bytes(&mut rs);
+            // Exercise the leading zero and high bit cases
+            rs[0] &= [0xff, 0x7f, 0x00][i as usize % 3];
+            rs[32] &= [0x00, 0xff, 0x7f][i as usize % 3];
+            let mut der = [0u8; ECDSA_DER_MAX_LEN];
+            let len = ecdsa_rs_to_der(&rs, &mut der);
+            let mut decoded = [0u8; 64];
+            assert_eq!(ecdsa_der_to_rs(&der[..len], &mut decoded), Some(()));
+            assert_eq!(decoded, rs);
+        }
+    }
+}
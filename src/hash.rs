@@ -0,0 +1,355 @@
+//! Incremental hash functions
+//!
+//! This module wraps the hash functions of the cryptographic library behind
+//! a common [`Hasher`] trait. Contexts are allocated on the stack, and
+//! updates never allocate.
+//!
+//! Each call to the cryptographic library is a syscall, which is expensive.
+//! Since parsers often hash data field by field, small updates are staged in
+//! a small buffer and passed to the library in a single call once it is full.
+//!
+//! The first error returned by the library is kept by the context, and
+//! reported by [`finalize`](Hasher::finalize).
+//!
+//! # Examples
+//!
+//! ```
+//! use nanos_sdk::hash::{Hasher, Sha256};
+//!
+//! let mut hasher = Sha256::new();
+//! hasher.update(&version);
+//! hasher.update(&amount);
+//! let digest: [u8; 32] = hasher.finalize()?;
+//! ```
+
+use crate::bindings::*;
+use crate::bytes::{zeroize, FixedBytes};
+use crate::io::SyscallError;
+
+/// Size of the buffer used to stage small updates.
+const STAGING_LEN: usize = 32;
+
+/// Common interface of the hash functions.
+pub trait Hasher: Sized {
+    /// Digest returned by [`finalize`](Hasher::finalize)
+    type Digest: FixedBytes;
+
+    /// Creates an initialized hash context.
+    fn new() -> Self;
+
+    /// Hashes `data`, after the data previously hashed.
+    fn update(&mut self, data: &[u8]);
+
+    /// Returns the digest of all the hashed data, or the first error returned
+    /// by the cryptographic library.
+    fn finalize(self) -> Result<Self::Digest, SyscallError>;
+
+    /// Returns the digest of `data`.
+    fn hash(data: &[u8]) -> Result<Self::Digest, SyscallError> {
+        let mut hasher = Self::new();
+        hasher.update(data);
+        hasher.finalize()
+    }
+}
+
+/// Buffer staging small updates before passing them to the cryptographic
+/// library.
+///
+/// Also keeps the first error returned by the library, starting with the
+/// one of the context initialization: once a call failed, the following
+/// ones are skipped.
+///
+/// The staged data is zeroized on drop, as it may be secret.
+struct Staging {
+    data: [u8; STAGING_LEN],
+    len: usize,
+    err: cx_err_t,
+}
+
+impl Staging {
+    /// `err` is the return code of the context initialization.
+    const fn new(err: cx_err_t) -> Staging {
+        Staging {
+            data: [0; STAGING_LEN],
+            len: 0,
+            err,
+        }
+    }
+
+    fn flush(&mut self, ctx: &mut cx_hash_t) {
+        if self.len > 0 {
+            if self.err == CX_OK {
+                self.err = unsafe { cx_hash_update(ctx, self.data.as_ptr(), self.len as u32) };
+            }
+            self.len = 0;
+        }
+    }
+
+    fn update(&mut self, ctx: &mut cx_hash_t, data: &[u8]) {
+        if self.len + data.len() > STAGING_LEN {
+            self.flush(ctx);
+        }
+        if data.len() > STAGING_LEN {
+            if self.err == CX_OK {
+                self.err = unsafe { cx_hash_update(ctx, data.as_ptr(), data.len() as u32) };
+            }
+        } else {
+            self.data[self.len..self.len + data.len()].copy_from_slice(data);
+            self.len += data.len();
+        }
+    }
+
+    fn finalize(&mut self, ctx: &mut cx_hash_t, digest: &mut [u8]) -> Result<(), SyscallError> {
+        self.flush(ctx);
+        if self.err == CX_OK {
+            self.err = unsafe { cx_hash_final(ctx, digest.as_mut_ptr()) };
+        }
+        match self.err {
+            CX_OK => Ok(()),
+            err => Err(err.into()),
+        }
+    }
+}
+
+impl Drop for Staging {
+    fn drop(&mut self) {
+        zeroize(&mut self.data);
+    }
+}
+
+/// SHA-256
+pub struct Sha256 {
+    ctx: cx_sha256_t,
+    staging: Staging,
+}
+
+impl Hasher for Sha256 {
+    type Digest = [u8; 32];
+
+    fn new() -> Self {
+        let mut ctx = cx_sha256_t::default();
+        let err = unsafe { cx_sha256_init_no_throw(&mut ctx) };
+        Sha256 {
+            ctx,
+            staging: Staging::new(err),
+        }
+    }
+
+    fn update(&mut self, data: &[u8]) {
+        self.staging.update(&mut self.ctx.header, data);
+    }
+
+    fn finalize(mut self) -> Result<Self::Digest, SyscallError> {
+        let mut digest = [0u8; 32];
+        self.staging.finalize(&mut self.ctx.header, &mut digest)?;
+        Ok(digest)
+    }
+}
+
+/// SHA-512
+pub struct Sha512 {
+    ctx: cx_sha512_t,
+    staging: Staging,
+}
+
+impl Hasher for Sha512 {
+    type Digest = [u8; 64];
+
+    fn new() -> Self {
+        let mut ctx = cx_sha512_t::default();
+        let err = unsafe { cx_sha512_init_no_throw(&mut ctx) };
+        Sha512 {
+            ctx,
+            staging: Staging::new(err),
+        }
+    }
+
+    fn update(&mut self, data: &[u8]) {
+        self.staging.update(&mut self.ctx.header, data);
+    }
+
+    fn finalize(mut self) -> Result<Self::Digest, SyscallError> {
+        let mut digest = [0u8; 64];
+        self.staging.finalize(&mut self.ctx.header, &mut digest)?;
+        Ok(digest)
+    }
+}
+
+/// Keccak-256, as used by Ethereum (not SHA3-256)
+pub struct Keccak256 {
+    ctx: cx_sha3_t,
+    staging: Staging,
+}
+
+impl Hasher for Keccak256 {
+    type Digest = [u8; 32];
+
+    fn new() -> Self {
+        let mut ctx = cx_sha3_t::default();
+        let err = unsafe { cx_keccak_init_no_throw(&mut ctx, 256) };
+        Keccak256 {
+            ctx,
+            staging: Staging::new(err),
+        }
+    }
+
+    fn update(&mut self, data: &[u8]) {
+        self.staging.update(&mut self.ctx.header, data);
+    }
+
+    fn finalize(mut self) -> Result<Self::Digest, SyscallError> {
+        let mut digest = [0u8; 32];
+        self.staging.finalize(&mut self.ctx.header, &mut digest)?;
+        Ok(digest)
+    }
+}
+
+/// BLAKE2b, with an `N` bytes digest, `N` being between 1 and 64.
+///
+/// Other digest sizes are rejected at compile time:
+///
+/// ```compile_fail
+/// use nanos_sdk::hash::{Blake2b, Hasher};
+/// let hasher = Blake2b::<65>::new();
+/// ```
+pub struct Blake2b<const N: usize> {
+    ctx: cx_blake2b_t,
+    staging: Staging,
+}
+
+impl<const N: usize> Blake2b<N> {
+    /// Evaluated when [`new`](Hasher::new) is instantiated, failing the build
+    /// for unsupported digest sizes.
+    const VALID_LEN: () = assert!(N >= 1 && N <= 64, "BLAKE2b digests are 1 to 64 bytes");
+}
+
+impl<const N: usize> Hasher for Blake2b<N> {
+    type Digest = [u8; N];
+
+    fn new() -> Self {
+        #[allow(clippy::let_unit_value)]
+        let _ = Self::VALID_LEN;
+        let mut ctx = cx_blake2b_t::default();
+        let err = unsafe { cx_blake2b_init_no_throw(&mut ctx, (N * 8) as u32) };
+        Blake2b {
+            ctx,
+            staging: Staging::new(err),
+        }
+    }
+
+    fn update(&mut self, data: &[u8]) {
+        self.staging.update(&mut self.ctx.header, data);
+    }
+
+    fn finalize(mut self) -> Result<Self::Digest, SyscallError> {
+        let mut digest = [0u8; N];
+        self.staging.finalize(&mut self.ctx.header, &mut digest)?;
+        Ok(digest)
+    }
+}
+
+/// RIPEMD-160
+pub struct Ripemd160 {
+    ctx: cx_ripemd160_t,
+    staging: Staging,
+}
+
+impl Hasher for Ripemd160 {
+    type Digest = [u8; 20];
+
+    fn new() -> Self {
+        let mut ctx = cx_ripemd160_t::default();
+        let err = unsafe { cx_ripemd160_init_no_throw(&mut ctx) };
+        Ripemd160 {
+            ctx,
+            staging: Staging::new(err),
+        }
+    }
+
+    fn update(&mut self, data: &[u8]) {
+        self.staging.update(&mut self.ctx.header, data);
+    }
+
+    fn finalize(mut self) -> Result<Self::Digest, SyscallError> {
+        let mut digest = [0u8; 20];
+        self.staging.finalize(&mut self.ctx.header, &mut digest)?;
+        Ok(digest)
+    }
+}
+
+#[cfg(all(test, not(feature = "host")))]
+mod tests {
+    use super::*;
+    use crate::assert_eq_err as assert_eq;
+    use crate::TestType;
+    use testmacro::test_item as test;
+
+    #[test]
+    fn sha256_staged_updates() {
+        // Small and large updates, staged or not, must give the same digest
+        let data = [0x42u8; 100];
+        let expected = Sha256::hash(&data)?;
+        let mut hasher = Sha256::new();
+        for chunk in [&data[..3], &data[3..10], &data[10..80], &data[80..]].iter() {
+            hasher.update(chunk);
+        }
+        assert_eq!(hasher.finalize()?, expected);
+    }
+
+    #[test]
+    fn sha256_abc() {
+        let digest = Sha256::hash(b"abc")?;
+        assert_eq!(digest[..4], [0xba, 0x78, 0x16, 0xbf]);
+    }
+
+    #[test]
+    fn sha512_abc() {
+        let expected = [
+            0xdd, 0xaf, 0x35, 0xa1, 0x93, 0x61, 0x7a, 0xba, 0xcc, 0x41, 0x73, 0x49, 0xae, 0x20,
+            0x41, 0x31, 0x12, 0xe6, 0xfa, 0x4e, 0x89, 0xa9, 0x7e, 0xa2, 0x0a, 0x9e, 0xee, 0xe6,
+            0x4b, 0x55, 0xd3, 0x9a, 0x21, 0x92, 0x99, 0x2a, 0x27, 0x4f, 0xc1, 0xa8, 0x36, 0xba,
+            0x3c, 0x23, 0xa3, 0xfe, 0xeb, 0xbd, 0x45, 0x4d, 0x44, 0x23, 0x64, 0x3c, 0xe8, 0x0e,
+            0x2a, 0x9a, 0xc9, 0x4f, 0xa5, 0x4c, 0xa4, 0x9f,
+        ];
+        assert_eq!(Sha512::hash(b"abc")?, expected);
+    }
+
+    #[test]
+    fn keccak256_empty() {
+        let expected = [
+            0xc5, 0xd2, 0x46, 0x01, 0x86, 0xf7, 0x23, 0x3c, 0x92, 0x7e, 0x7d, 0xb2, 0xdc, 0xc7,
+            0x03, 0xc0, 0xe5, 0x00, 0xb6, 0x53, 0xca, 0x82, 0x27, 0x3b, 0x7b, 0xfa, 0xd8, 0x04,
+            0x5d, 0x85, 0xa4, 0x70,
+        ];
+        assert_eq!(Keccak256::hash(b"")?, expected);
+    }
+
+    #[test]
+    fn blake2b_abc() {
+        // Both the full size digest and a shorter one, which the digest size
+        // given to the library must match
+        let expected = [
+            0xba, 0x80, 0xa5, 0x3f, 0x98, 0x1c, 0x4d, 0x0d, 0x6a, 0x27, 0x97, 0xb6, 0x9f, 0x12,
+            0xf6, 0xe9, 0x4c, 0x21, 0x2f, 0x14, 0x68, 0x5a, 0xc4, 0xb7, 0x4b, 0x12, 0xbb, 0x6f,
+            0xdb, 0xff, 0xa2, 0xd1, 0x7d, 0x87, 0xc5, 0x39, 0x2a, 0xab, 0x79, 0x2d, 0xc2, 0x52,
+            0xd5, 0xde, 0x45, 0x33, 0xcc, 0x95, 0x18, 0xd3, 0x8a, 0xa8, 0xdb, 0xf1, 0x92, 0x5a,
+            0xb9, 0x23, 0x86, 0xed, 0xd4, 0x00, 0x99, 0x23,
+        ];
+        assert_eq!(Blake2b::<64>::hash(b"abc")?, expected);
+        let expected = [
+            0xbd, 0xdd, 0x81, 0x3c, 0x63, 0x42, 0x39, 0x72, 0x31, 0x71, 0xef, 0x3f, 0xee, 0x98,
+            0x57, 0x9b, 0x94, 0x96, 0x4e, 0x3b, 0xb1, 0xcb, 0x3e, 0x42, 0x72, 0x62, 0xc8, 0xc0,
+            0x68, 0xd5, 0x23, 0x19,
+        ];
+        assert_eq!(Blake2b::<32>::hash(b"abc")?, expected);
+    }
+
+    #[test]
+    fn ripemd160_abc() {
+        let expected = [
+            0x8e, 0xb2, 0x08, 0xf7, 0xe0, 0x5d, 0x98, 0x7a, 0x9b, 0x04, 0x4a, 0x8e, 0x98, 0xc6,
+            0xb0, 0x87, 0xf1, 0x5a, 0x0b, 0xfc,
+        ];
+        assert_eq!(Ripemd160::hash(b"abc")?, expected);
+    }
+}
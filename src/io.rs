@@ -2,7 +2,8 @@ use crate::bindings::*;
 use crate::buttons::{get_button_event, ButtonEvent, ButtonsState};
 use crate::seph;
 use core::convert::TryFrom;
-use core::ops::{Index, IndexMut};
+use core::ffi::c_void;
+use core::ops::{Index, IndexMut, Range};
 
 #[derive(Copy, Clone)]
 #[repr(u16)]
@@ -71,6 +72,59 @@ extern "C" {
         sndlength: u16,
         apdu_buffer: *const u8,
     );
+    pub fn io_usb_hid_set_chunk_callback(
+        callback: Option<unsafe extern "C" fn(*mut c_void, *const u8, u16, u32)>,
+        ctx: *mut c_void,
+    );
+}
+
+/// Consumer of command APDU data, fed chunk by chunk while the command is
+/// being received. See [`Comm::next_event_streaming`].
+pub trait ApduSink {
+    /// Processes the next chunk of the command APDU.
+    ///
+    /// # Arguments
+    ///
+    /// * `offset` - Position of `chunk` in the APDU. The APDU header (CLA,
+    ///   INS, P1, P2 and Lc) is part of the first chunk.
+    /// * `chunk` - Received bytes.
+    fn feed(&mut self, offset: usize, chunk: &[u8]);
+
+    /// Called when the command fed so far is discarded without being
+    /// returned to the application, such as a command with an invalid
+    /// instruction byte, which is answered automatically. The next chunk
+    /// starts a new command, at offset 0.
+    ///
+    /// A command whose reception is interrupted by the host is not
+    /// reported: a chunk at offset 0 always starts a new command, and the
+    /// fed data only belongs to a command once it is returned by
+    /// [`Event::Command`].
+    fn abort(&mut self) {}
+}
+
+impl<F: FnMut(usize, &[u8])> ApduSink for F {
+    fn feed(&mut self, offset: usize, chunk: &[u8]) {
+        self(offset, chunk)
+    }
+}
+
+unsafe extern "C" fn apdu_sink_trampoline<S: ApduSink>(
+    ctx: *mut c_void,
+    chunk: *const u8,
+    length: u16,
+    offset: u32,
+) {
+    let sink = &mut *(ctx as *mut S);
+    sink.feed(
+        offset as usize,
+        core::slice::from_raw_parts(chunk, length as usize),
+    );
+}
+
+/// Returns true if a command has been entirely received and not answered
+/// yet.
+fn command_received() -> bool {
+    unsafe { G_io_app.apdu_state != APDU_IDLE && G_io_app.apdu_length > 0 }
 }
 
 /// Possible events returned by [`Comm::next_event`]
@@ -81,63 +135,275 @@ pub enum Event<T> {
     Button(ButtonEvent),
     /// Ticker
     Ticker,
+    /// The response started with [`Comm::reply_async`] has been entirely
+    /// transmitted
+    ReplySent,
+}
+
+/// Handle on a response being transmitted, returned by [`Comm::reply_async`].
+#[must_use]
+pub struct PendingReply(());
+
+impl PendingReply {
+    /// Returns true once the response has been entirely transmitted.
+    pub fn is_sent<const N: usize>(&self, comm: &Comm<N>) -> bool {
+        !comm.reply_pending || unsafe { G_io_app.apdu_state } == APDU_IDLE
+    }
+
+    /// Blocks until the response has been entirely transmitted.
+    /// Button events received in the meantime are discarded.
+    pub fn wait<const N: usize>(self, comm: &mut Comm<N>) {
+        comm.wait_reply_sent();
+    }
+}
+
+/// Command of a batch APDU, see [`Comm::handle_batch`]
+pub struct BatchCommand<'a> {
+    pub cla: u8,
+    pub ins: u8,
+    pub p1: u8,
+    pub p2: u8,
+    pub data: &'a [u8],
+}
+
+/// Iterator over the commands of a batch APDU, see [`Comm::batch_commands`].
+/// Yields an error and stops if the batch is malformed.
+pub struct BatchCommands<'a> {
+    data: &'a [u8],
+}
+
+impl<'a> Iterator for BatchCommands<'a> {
+    type Item = Result<BatchCommand<'a>, StatusWords>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        let data = self.data;
+        if data.is_empty() {
+            return None;
+        }
+        if data.len() < 5 || data.len() < 5 + data[4] as usize {
+            self.data = &[];
+            return Some(Err(StatusWords::BadLen));
+        }
+        let end = 5 + data[4] as usize;
+        self.data = &data[end..];
+        Some(Ok(BatchCommand {
+            cla: data[0],
+            ins: data[1],
+            p1: data[2],
+            p2: data[3],
+            data: &data[5..end],
+        }))
+    }
 }
 
-pub struct Comm {
-    pub apdu_buffer: [u8; 260],
+/// Response data of a command of a batch APDU, see [`Comm::handle_batch`]
+pub struct BatchResponse<'a> {
+    buffer: &'a mut [u8],
+    len: usize,
+}
+
+impl<'a> BatchResponse<'a> {
+    /// Appends `m` to the response data. Fails if the response would exceed
+    /// 255 bytes or the room left in the APDU buffer.
+    pub fn append(&mut self, m: &[u8]) -> Result<(), StatusWords> {
+        let end = self.len + m.len();
+        if end > self.buffer.len() {
+            return Err(StatusWords::BadLen);
+        }
+        self.buffer[self.len..end].copy_from_slice(m);
+        self.len = end;
+        Ok(())
+    }
+}
+
+/// Size of the APDU buffer of a default [`Comm`]: a short APDU header, 255
+/// bytes of data and the Le byte.
+pub const DEFAULT_APDU_BUFFER_SIZE: usize = 260;
+
+/// APDU communication handle.
+///
+/// `N` is the size of the APDU buffer. Commands received over USB HID are
+/// reassembled directly into this buffer, so extended-length APDUs up to `N`
+/// bytes can be received in a single exchange, instead of being split in
+/// multiple chunked commands by the host. The buffer lives wherever the
+/// `Comm` lives (usually the stack of the application main loop), so `N`
+/// must fit in the RAM budget of the application. Large buffers are better
+/// kept in a static, created with [`const_default`](Comm::const_default),
+/// as the stack is small. The transport encodes lengths on 16 bits, which
+/// bounds `N` to 65535.
+///
+/// Over the raw seproxyhal channel, a command comes in a single packet and
+/// is limited to [`RAW_APDU_MAX_LEN`](seph::RAW_APDU_MAX_LEN) bytes: larger
+/// ones are answered with `BadLen` without being returned to the
+/// application.
+///
+/// # Examples
+///
+/// ```
+/// // Default buffer, for short APDUs
+/// let mut comm = Comm::new();
+/// // 1 KiB buffer, for extended APDUs
+/// let mut comm = Comm::<1024>::default();
+/// // Same, out of the stack
+/// static mut COMM: Comm<1024> = Comm::const_default();
+/// ```
+pub struct Comm<const N: usize = DEFAULT_APDU_BUFFER_SIZE> {
+    pub apdu_buffer: [u8; N],
     pub rx: usize,
     pub tx: usize,
     buttons: ButtonsState,
+    reply_pending: bool,
+    /// A command has been received by [`handle_event`](Comm::handle_event),
+    /// to be returned by the next call to `next_event`.
+    command_pending: bool,
+    /// Class and instruction of the NVM statistics APDU, if enabled.
+    #[cfg(feature = "nvm_stats")]
+    nvm_stats_apdu: Option<(u8, u8)>,
 }
 
-impl Default for Comm {
+impl<const N: usize> Default for Comm<N> {
     fn default() -> Self {
+        Self::const_default()
+    }
+}
+
+impl Comm {
+    pub fn new() -> Self {
+        Self::default()
+    }
+}
+
+impl<const N: usize> Comm<N> {
+    /// Same as [`default`](Default::default), usable to initialize a static.
+    pub const fn const_default() -> Self {
+        // Short APDU header + status word is the bare minimum.
+        assert!(N >= 7 && N <= u16::MAX as usize);
         Self {
-            apdu_buffer: [0u8; 260],
+            apdu_buffer: [0u8; N],
             rx: 0,
             tx: 0,
             buttons: ButtonsState::new(),
+            reply_pending: false,
+            command_pending: false,
+            #[cfg(feature = "nvm_stats")]
+            nvm_stats_apdu: None,
         }
     }
-}
 
-impl Comm {
-    pub fn new() -> Self {
-        Self::default()
+    /// Returns the size of the APDU buffer, which is the maximum length of
+    /// received commands and transmitted responses.
+    pub const fn capacity(&self) -> usize {
+        N
+    }
+
+    /// Answers the commands with class `cla` and instruction `ins` with the
+    /// NVM statistics (see [`nvm::stats`](crate::nvm::stats)), without
+    /// passing them to the application. Disabled by default, so that no
+    /// command is taken from the application unless it asks for it.
+    ///
+    /// ```
+    /// comm.enable_nvm_stats(nvm::stats::CLA, nvm::stats::INS);
+    /// ```
+    #[cfg(feature = "nvm_stats")]
+    pub fn enable_nvm_stats(&mut self, cla: u8, ins: u8) {
+        self.nvm_stats_apdu = Some((cla, ins));
     }
 
     /// Send the currently held APDU
     // This is private. Users should call reply to set the satus word and
     // transmit the response.
     fn apdu_send(&mut self) {
+        self.apdu_send_start();
+        self.reply_pending = false;
+        unsafe {
+            G_io_app.apdu_state = APDU_IDLE;
+        }
+    }
+
+    /// Start transmitting the currently held APDU. Over USB HID, only the
+    /// first segment is sent here, the following ones being sent as the
+    /// transfer events are processed.
+    fn apdu_send_start(&mut self) {
+        #[cfg(feature = "profiling")]
+        let _scope = crate::profiling::scope(crate::profiling::APDU_SEND, self.tx as u32);
+        if self.reply_pending {
+            self.wait_reply_sent();
+        }
         if !seph::is_status_sent() {
             seph::send_general_status()
         }
-        let mut spi_buffer = [0u8; 128];
+        let mut spi_buffer = [0u8; seph::SEPH_BUFFER_SIZE];
         while seph::is_status_sent() {
             seph::seph_recv(&mut spi_buffer, 0);
             seph::handle_event(&mut self.apdu_buffer, &spi_buffer);
         }
 
-        match unsafe { G_io_app.apdu_state } {
-            APDU_USB_HID => unsafe {
-                io_usb_hid_send(
-                    io_usb_send_apdu_data,
-                    self.tx as u16,
-                    self.apdu_buffer.as_ptr(),
-                );
-            },
+        // io_usb_hid_sent resets the APDU state once the last segment has
+        // been acknowledged. The raw channel is done already, its state is
+        // reset here so that the next call to next_event reports it.
+        self.reply_pending = match unsafe { G_io_app.apdu_state } {
+            APDU_USB_HID => {
+                unsafe {
+                    io_usb_hid_send(
+                        io_usb_send_apdu_data,
+                        self.tx as u16,
+                        self.apdu_buffer.as_ptr(),
+                    );
+                }
+                true
+            }
             APDU_RAW => {
                 let len = (self.tx as u16).to_be_bytes();
                 seph::seph_send(&[seph::SephTags::RawAPDU as u8, len[0], len[1]]);
                 seph::seph_send(&self.apdu_buffer[..self.tx]);
+                unsafe {
+                    G_io_app.apdu_state = APDU_IDLE;
+                }
+                true
             }
-            _ => (),
-        }
+            _ => false,
+        };
         self.tx = 0;
         self.rx = 0;
-        unsafe {
-            G_io_app.apdu_state = APDU_IDLE;
+    }
+
+    /// Returns true if a response started with [`reply_async`](Comm::reply_async)
+    /// has just been entirely transmitted, and prepares the reception of the
+    /// next command.
+    fn reply_sent(&mut self) -> bool {
+        if self.reply_pending && unsafe { G_io_app.apdu_state } == APDU_IDLE {
+            self.reply_pending = false;
+            unsafe {
+                G_io_app.apdu_media = IO_APDU_MEDIA_NONE;
+                G_io_app.apdu_length = 0;
+            }
+            true
+        } else {
+            false
+        }
+    }
+
+    /// Handles an event received outside of [`next_event`](Comm::next_event),
+    /// such as while the display is refreshed. A command received this way
+    /// is returned by the next call to `next_event`.
+    pub(crate) fn handle_event(&mut self, spi_buffer: &[u8]) {
+        let received = command_received();
+        seph::handle_event(&mut self.apdu_buffer, spi_buffer);
+        if !received && command_received() {
+            self.command_pending = true;
+        }
+    }
+
+    /// Process events until the pending response has been entirely
+    /// transmitted.
+    fn wait_reply_sent(&mut self) {
+        let mut spi_buffer = [0u8; seph::SEPH_BUFFER_SIZE];
+        while !self.reply_sent() {
+            if !seph::is_status_sent() {
+                seph::send_general_status();
+            }
+            seph::seph_recv(&mut spi_buffer, 0);
+            seph::handle_event(&mut self.apdu_buffer, &spi_buffer);
         }
     }
 
@@ -195,6 +461,7 @@ impl Comm {
     ///         Event::Button(button) => { ... }
     ///         Event::Command(Instruction::Select) => { ... }
     ///         Event::Command(Instruction::ReadBinary) => { ... }
+    ///         Event::Ticker | Event::ReplySent => (),
     ///     }
     /// }
     /// ```
@@ -202,12 +469,34 @@ impl Comm {
     /// In this later example, invalid instruction byte error handling is
     /// automatically performed by the `next_event` method itself.
     pub fn next_event<T: TryFrom<u8>>(&mut self) -> Event<T> {
-        let mut spi_buffer = [0u8; 128];
+        self.next_event_dropping(|| ())
+    }
 
-        unsafe {
-            G_io_app.apdu_state = APDU_IDLE;
-            G_io_app.apdu_media = IO_APDU_MEDIA_NONE;
-            G_io_app.apdu_length = 0;
+    /// Same as [`next_event`](Comm::next_event), calling `on_drop` when a
+    /// received command is answered without being returned.
+    fn next_event_dropping<T: TryFrom<u8>, F: FnMut()>(&mut self, mut on_drop: F) -> Event<T> {
+        #[cfg(feature = "profiling")]
+        let _scope = crate::profiling::scope(crate::profiling::NEXT_EVENT, 0);
+        let mut spi_buffer = [0u8; seph::SEPH_BUFFER_SIZE];
+
+        // Responses over the raw channel are sent at once
+        if self.reply_sent() {
+            return Event::ReplySent;
+        }
+
+        if core::mem::take(&mut self.command_pending) {
+            if let Some(event) = self.take_command(&mut on_drop) {
+                return event;
+            }
+        }
+
+        // Do not interrupt the transmission of a pending response
+        if !self.reply_pending {
+            unsafe {
+                G_io_app.apdu_state = APDU_IDLE;
+                G_io_app.apdu_media = IO_APDU_MEDIA_NONE;
+                G_io_app.apdu_length = 0;
+            }
         }
 
         loop {
@@ -255,28 +544,103 @@ impl Comm {
                     }
                 }
                 seph::Events::CAPDUEvent => {
-                    seph::handle_capdu_event(&mut self.apdu_buffer, &spi_buffer)
+                    if let Err(sw) = seph::handle_capdu_event(&mut self.apdu_buffer, &spi_buffer) {
+                        self.reply(sw);
+                        continue;
+                    }
                 }
                 seph::Events::TickerEvent => return Event::Ticker,
                 _ => (),
             }
 
-            if unsafe { G_io_app.apdu_state } != APDU_IDLE && unsafe { G_io_app.apdu_length } > 0 {
-                self.rx = unsafe { G_io_app.apdu_length as usize };
-                let res = T::try_from(self.apdu_buffer[1]);
-                match res {
-                    Ok(ins) => {
-                        return Event::Command(ins);
-                    }
-                    Err(_) => {
-                        // Invalid Ins code. Send automatically an error, mask
-                        // the bad instruction to the application and just
-                        // discard this event.
-                        self.reply(StatusWords::BadCla);
-                    }
+            if self.reply_pending {
+                if self.reply_sent() {
+                    return Event::ReplySent;
                 }
+                continue;
+            }
+
+            if let Some(event) = self.take_command(&mut on_drop) {
+                return event;
+            }
+        }
+    }
+
+    /// Returns the event of the received command, if any. Commands which are
+    /// not for the application are answered here, and `on_drop` is called.
+    fn take_command<T: TryFrom<u8>, F: FnMut()>(&mut self, on_drop: &mut F) -> Option<Event<T>> {
+        if !command_received() {
+            return None;
+        }
+        self.rx = unsafe { G_io_app.apdu_length as usize };
+        #[cfg(feature = "nvm_stats")]
+        if self.nvm_stats_apdu == Some((self.apdu_buffer[0], self.apdu_buffer[1])) {
+            on_drop();
+            crate::nvm::stats::reply(self);
+            return None;
+        }
+        let res = T::try_from(self.apdu_buffer[1]);
+        match res {
+            Ok(ins) => Some(Event::Command(ins)),
+            Err(_) => {
+                // Invalid Ins code. Send automatically an error, mask
+                // the bad instruction to the application and just
+                // discard this event.
+                on_drop();
+                self.reply(StatusWords::BadCla);
+                None
+            }
+        }
+    }
+
+    /// Same as [`next_event`](Comm::next_event), but `sink` is fed with the
+    /// command APDU as it is being received.
+    ///
+    /// Over USB HID, each segment is passed to `sink` as soon as it has been
+    /// copied into the APDU buffer, while the next segment is in flight. This
+    /// allows hashing or parsing a large command as it arrives instead of
+    /// after its reception. Over the raw seproxyhal channel the command comes
+    /// in one piece and is fed at once.
+    ///
+    /// If another event is returned while a command is only partially
+    /// received, the next calls should also use this method with the same
+    /// sink, so that no segment is missed. Commands answered without being
+    /// returned are reported to the sink with [`ApduSink::abort`].
+    ///
+    /// # Examples
+    ///
+    /// ```
+    /// let mut received = 0;
+    /// let mut sink = |_offset: usize, chunk: &[u8]| received += chunk.len();
+    /// match comm.next_event_streaming(&mut sink) {
+    ///     Event::Command(0x02) => { ... }
+    ///     _ => { ... }
+    /// }
+    /// ```
+    pub fn next_event_streaming<T: TryFrom<u8>, S: ApduSink>(&mut self, sink: &mut S) -> Event<T> {
+        let ctx = sink as *mut S;
+        unsafe {
+            io_usb_hid_set_chunk_callback(Some(apdu_sink_trampoline::<S>), ctx as *mut c_void);
+        }
+        // Raw commands and commands received outside of this method, which
+        // come first, are only fed once returned
+        let mut unfed = self.command_pending;
+        let event = self.next_event_dropping(|| unsafe {
+            if unfed {
+                unfed = false;
+            } else if G_io_app.apdu_media != IO_APDU_MEDIA_RAW {
+                (*ctx).abort();
+            }
+        });
+        unsafe {
+            io_usb_hid_set_chunk_callback(None, core::ptr::null_mut());
+        }
+        if let Event::Command(_) = event {
+            if unfed || unsafe { G_io_app.apdu_media } == IO_APDU_MEDIA_RAW {
+                sink.feed(0, &self.apdu_buffer[..self.rx]);
             }
         }
+        event
     }
 
     /// Wait for the next Command event. Returns the APDU Instruction byte value
@@ -338,6 +702,33 @@ impl Comm {
         self.apdu_send();
     }
 
+    /// Same as [`reply`](Comm::reply), but returns as soon as the first
+    /// segment of the response is sent, instead of waiting for the whole
+    /// response to be transmitted.
+    ///
+    /// The application can then work on its next step while the remaining
+    /// segments are transmitted by [`next_event`](Comm::next_event), which
+    /// returns [`Event::ReplySent`] once the transfer is complete. Over the
+    /// raw seproxyhal channel, the response is sent at once, and the next
+    /// call to `next_event` returns `Event::ReplySent` right away. The
+    /// returned handle can also be used to check or wait for completion.
+    ///
+    /// The APDU buffer must not be modified until the response is sent, as
+    /// segments are read from it as they go.
+    ///
+    /// # Examples
+    ///
+    /// ```
+    /// let pending = comm.reply_async(StatusWords::Ok);
+    /// let next_key = derive_next_key();
+    /// pending.wait(&mut comm);
+    /// ```
+    pub fn reply_async<T: Into<Reply>>(&mut self, reply: T) -> PendingReply {
+        self.append(&reply.into().0.to_be_bytes());
+        self.apdu_send_start();
+        PendingReply(())
+    }
+
     /// Set the Status Word of the response to `StatusWords::OK` (which is equal
     /// to `0x9000`, and transmit the response.
     pub fn reply_ok(&mut self) {
@@ -359,24 +750,36 @@ impl Comm {
         self.apdu_buffer[3]
     }
 
+    /// Returns the data field of the received APDU, borrowed from the APDU
+    /// buffer.
+    ///
+    /// Both short (`Lc` on one byte) and extended (`00` followed by `Lc` on two
+    /// big-endian bytes) length encodings are supported.
     pub fn get_data(&self) -> Result<&[u8], StatusWords> {
+        let range = self.data_range()?;
+        Ok(&self.apdu_buffer[range])
+    }
+
+    /// Returns the position of the data field of the received APDU in the
+    /// APDU buffer.
+    fn data_range(&self) -> Result<Range<usize>, StatusWords> {
         if self.rx == 4 {
-            Ok(&[]) // Conforming zero-data APDU
+            Ok(0..0) // Conforming zero-data APDU
         } else {
             let first_len_byte = self.apdu_buffer[4] as usize;
             let get_data_from_buffer = |len, offset| {
                 if len == 0 || len + offset > self.rx {
                     Err(StatusWords::BadLen)
                 } else {
-                    Ok(&self.apdu_buffer[offset..offset + len])
+                    Ok(offset..offset + len)
                 }
             };
             match (first_len_byte, self.rx) {
-                (0, 5) => Ok(&[]), // Non-conforming zero-data APDU
+                (0, 5) => Ok(0..0), // Non-conforming zero-data APDU
                 (0, 6) => Err(StatusWords::BadLen),
                 (0, _) => {
                     let len =
-                        u16::from_le_bytes([self.apdu_buffer[5], self.apdu_buffer[6]]) as usize;
+                        u16::from_be_bytes([self.apdu_buffer[5], self.apdu_buffer[6]]) as usize;
                     get_data_from_buffer(len, 7)
                 }
                 (len, _) => get_data_from_buffer(len, 5),
@@ -384,28 +787,266 @@ impl Comm {
         }
     }
 
+    /// Returns an iterator over the commands of a received batch APDU. See
+    /// [`handle_batch`](Comm::handle_batch) for the batch format.
+    pub fn batch_commands(&self) -> Result<BatchCommands<'_>, StatusWords> {
+        Ok(BatchCommands {
+            data: self.get_data()?,
+        })
+    }
+
+    /// Processes a received batch APDU, and transmits the responses of all
+    /// the commands it contains in a single response.
+    ///
+    /// This is opt-in: the application picks an instruction code for batches
+    /// and calls this method when receiving it. Each command of the batch is
+    /// passed to `handler`, which writes its response data and returns its
+    /// status word, like it would for a standalone command. This saves the
+    /// seproxyhal and transport round trips of each command.
+    ///
+    /// The data of a batch APDU is the concatenation of short commands, each
+    /// with an explicit Lc:
+    ///
+    /// `CLA INS P1 P2 Lc Data[Lc]` ... `CLA INS P1 P2 Lc Data[Lc]`
+    ///
+    /// The response data is the concatenation, in the same order, of:
+    ///
+    /// `Lr Data[Lr] SW1 SW2`
+    ///
+    /// followed by the `0x9000` status word. Responses are written after the
+    /// batch in the APDU buffer, so the buffer must be large enough to hold
+    /// both. If the batch is malformed, or if there is no room for the `Lr`
+    /// and status word of every command, a `BadLen` status word is returned
+    /// instead, without running any command. The room left for the data of
+    /// each response excludes what is needed by the following commands, so a
+    /// response which does not fit only fails its own command, with the
+    /// status word returned by `handler`.
+    ///
+    /// # Examples
+    ///
+    /// ```
+    /// match comm.next_command() {
+    ///     0xb0 => comm.handle_batch(|cmd, response| match cmd.ins {
+    ///         0x02 => match response.append(&get_pubkey(cmd.data)) {
+    ///             Ok(()) => StatusWords::Ok.into(),
+    ///             Err(sw) => sw.into(),
+    ///         },
+    ///         _ => StatusWords::BadCla.into(),
+    ///     }),
+    ///     ...
+    /// }
+    /// ```
+    pub fn handle_batch<F>(&mut self, handler: F)
+    where
+        F: FnMut(&BatchCommand, &mut BatchResponse) -> Reply,
+    {
+        match self.run_batch(handler) {
+            Ok(()) => self.reply_ok(),
+            Err(sw) => self.reply(sw),
+        }
+    }
+
+    /// Runs the commands of a received batch APDU, and writes their
+    /// responses at the start of the APDU buffer.
+    fn run_batch<F>(&mut self, mut handler: F) -> Result<(), StatusWords>
+    where
+        F: FnMut(&BatchCommand, &mut BatchResponse) -> Reply,
+    {
+        let range = self.data_range()?;
+        let mut count = 0;
+        for command in (BatchCommands {
+            data: &self.apdu_buffer[range.clone()],
+        }) {
+            command?;
+            count += 1;
+        }
+
+        let (request, responses) = self.apdu_buffer.split_at_mut(range.end);
+        // Room for Lr and the status word of each command is required
+        if responses.len() < 3 * count {
+            return Err(StatusWords::BadLen);
+        }
+        let mut tx = 0;
+        for (i, command) in (BatchCommands {
+            data: &request[range.start..],
+        })
+        .flatten()
+        .enumerate()
+        {
+            let available = responses.len() - tx - 3 * (count - i - 1);
+            let mut response = BatchResponse {
+                buffer: &mut responses[tx + 1..tx + available.min(255 + 3) - 2],
+                len: 0,
+            };
+            let sw = handler(&command, &mut response).0;
+            let len = response.len;
+            responses[tx] = len as u8;
+            responses[tx + 1 + len..tx + 3 + len].copy_from_slice(&sw.to_be_bytes());
+            tx += len + 3;
+        }
+
+        self.apdu_buffer.copy_within(range.end..range.end + tx, 0);
+        self.tx = tx;
+        Ok(())
+    }
+
     pub fn get(&self, start: usize, end: usize) -> &[u8] {
         &self.apdu_buffer[start..end]
     }
 
     pub fn append(&mut self, m: &[u8]) {
-        for c in m.iter() {
-            self.apdu_buffer[self.tx] = *c;
-            self.tx += 1;
-        }
+        self.apdu_buffer[self.tx..self.tx + m.len()].copy_from_slice(m);
+        self.tx += m.len();
     }
 }
 
-impl Index<usize> for Comm {
+impl<const N: usize> Index<usize> for Comm<N> {
     type Output = u8;
     fn index(&self, idx: usize) -> &Self::Output {
         &self.apdu_buffer[idx]
     }
 }
 
-impl IndexMut<usize> for Comm {
+impl<const N: usize> IndexMut<usize> for Comm<N> {
     fn index_mut(&mut self, idx: usize) -> &mut Self::Output {
         self.tx = idx.max(self.tx);
         &mut self.apdu_buffer[idx]
     }
 }
+
+// These tests also run natively with the `host` feature
+#[cfg(test)]
+mod tests {
+    use super::*;
+    #[cfg(not(feature = "host"))]
+    use crate::assert_eq_err as assert_eq;
+    #[cfg(not(feature = "host"))]
+    use crate::TestType;
+    #[cfg(not(feature = "host"))]
+    use testmacro::test_item as test;
+
+    // Unwraps a result like `?`: under testmacro, an error fails the test
+    // without aborting the whole run, while natively each test can panic.
+    macro_rules! check {
+        ($e:expr) => {
+            match $e {
+                Ok(v) => v,
+                #[cfg(not(feature = "host"))]
+                Err(_) => return Err(()),
+                #[cfg(feature = "host")]
+                Err(_) => panic!("unexpected error"),
+            }
+        };
+    }
+
+    #[test]
+    fn get_data_short() {
+        let mut comm = Comm::new();
+        comm.apdu_buffer[..8].copy_from_slice(&[0xe0, 0x02, 0, 0, 3, 1, 2, 3]);
+        comm.rx = 8;
+        assert_eq!(comm.get_data().ok(), Some(&[1u8, 2, 3][..]));
+    }
+
+    #[test]
+    fn get_data_extended() {
+        // Extended Lc is big-endian: 0x0102 bytes of data
+        let mut comm = Comm::<512>::default();
+        comm.apdu_buffer[..7].copy_from_slice(&[0xe0, 0x02, 0, 0, 0, 0x01, 0x02]);
+        comm.rx = 7 + 0x102;
+        assert_eq!(comm.get_data().map(|d| d.len()).ok(), Some(0x102));
+    }
+
+    #[cfg(feature = "host")]
+    #[test]
+    fn raw_apdu_too_long() {
+        // The command of a CAPDU event is limited by the seproxyhal packet,
+        // not by the APDU buffer: a longer one is rejected, not truncated
+        let mut comm = Comm::<1024>::default();
+        let mut packet = [0u8; seph::SEPH_BUFFER_SIZE];
+        packet[0] = SEPROXYHAL_TAG_CAPDU_EVENT as u8;
+        for &(len, accepted) in &[(seph::RAW_APDU_MAX_LEN, true), (200, false)] {
+            packet[1..3].copy_from_slice(&(len as u16).to_be_bytes());
+            unsafe { G_io_app.apdu_state = APDU_IDLE };
+            let res = seph::handle_capdu_event(&mut comm.apdu_buffer, &packet);
+            assert_eq!(res.is_ok(), accepted);
+            let expected = if accepted { len } else { 0 };
+            assert_eq!(unsafe { G_io_app.apdu_length } as usize, expected);
+        }
+    }
+
+    #[test]
+    fn batch_commands() {
+        let mut comm = Comm::new();
+        let apdu = [
+            0xe0, 0xb0, 0, 0, 12, // batch header
+            0xe0, 0x02, 1, 2, 1, 0xaa, // first command
+            0xe0, 0x04, 3, 4, 0,    // second command, without data
+            0xe0, // truncated command
+        ];
+        comm.apdu_buffer[..apdu.len()].copy_from_slice(&apdu);
+        comm.rx = apdu.len();
+        let mut commands = check!(comm.batch_commands());
+        let first = check!(commands.next().unwrap_or(Err(StatusWords::BadLen)));
+        assert_eq!(
+            (first.ins, first.p1, first.p2, first.data),
+            (0x02, 1, 2, &[0xaa][..])
+        );
+        let second = check!(commands.next().unwrap_or(Err(StatusWords::BadLen)));
+        assert_eq!((second.ins, second.data.len()), (0x04, 0));
+        assert_eq!(commands.next().map(|c| c.is_err()), Some(true));
+        assert_eq!(commands.next().is_none(), true);
+    }
+
+    // Batch of a command echoing 3 bytes of data, and a command without data
+    const BATCH: [u8; 18] = [
+        0xe0, 0xb0, 0, 0, 13, // batch header
+        0xe0, 0x02, 0, 0, 3, 1, 2, 3, // echo command
+        0xe0, 0x04, 0, 0, 0, // unknown command
+    ];
+
+    fn run_echo_batch<const N: usize>(
+        comm: &mut Comm<N>,
+        runs: &mut usize,
+    ) -> Result<(), StatusWords> {
+        comm.apdu_buffer[..BATCH.len()].copy_from_slice(&BATCH);
+        comm.rx = BATCH.len();
+        comm.tx = 0;
+        comm.run_batch(|command, response| {
+            *runs += 1;
+            match command.ins {
+                0x02 => match response.append(command.data) {
+                    Ok(()) => StatusWords::Ok.into(),
+                    Err(sw) => sw.into(),
+                },
+                _ => StatusWords::Unknown.into(),
+            }
+        })
+    }
+
+    #[test]
+    fn batch_responses() {
+        let mut comm = Comm::<32>::default();
+        let mut runs = 0;
+        check!(run_echo_batch(&mut comm, &mut runs));
+        assert_eq!(runs, 2);
+        assert_eq!(
+            comm.get(0, comm.tx),
+            &[3, 1, 2, 3, 0x90, 0x00, 0, 0x6d, 0x00][..]
+        );
+    }
+
+    #[test]
+    fn batch_overflow() {
+        // The echo does not fit, as room is kept for the second status word
+        let mut comm = Comm::<25>::default();
+        let mut runs = 0;
+        check!(run_echo_batch(&mut comm, &mut runs));
+        assert_eq!(runs, 2);
+        assert_eq!(comm.get(0, comm.tx), &[0, 0x6e, 0x01, 0, 0x6d, 0x00][..]);
+        // No command runs if the status words do not all fit
+        let mut comm = Comm::<22>::default();
+        let mut runs = 0;
+        assert_eq!(run_echo_batch(&mut comm, &mut runs).is_err(), true);
+        assert_eq!((runs, comm.tx), (0, 0));
+    }
+}
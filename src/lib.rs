@@ -1,19 +1,26 @@
-#![no_std]
-#![cfg_attr(test, no_main)]
+#![cfg_attr(not(feature = "host"), no_std)]
+#![cfg_attr(all(test, not(feature = "host")), no_main)]
 #![feature(custom_test_frameworks)]
-#![reexport_test_harness_main = "test_main"]
-#![test_runner(sdk_test_runner)]
+#![cfg_attr(not(feature = "host"), reexport_test_harness_main = "test_main")]
+#![cfg_attr(not(feature = "host"), test_runner(sdk_test_runner))]
 #![feature(asm)]
 #![feature(const_panic)]
 #![cfg_attr(not(feature = "pre1_54"), feature(const_fn_trait_bound))]
 
 pub mod bindings;
 pub mod buttons;
+pub mod bytes;
 pub mod ecc;
+pub mod hash;
 pub mod io;
+#[cfg(feature = "host")]
+pub mod mock;
 pub mod nvm;
+#[cfg(feature = "profiling")]
+pub mod profiling;
 pub mod random;
 pub mod seph;
+pub mod ui;
 pub mod usbbindings;
 
 use bindings::os_sched_exit;
@@ -22,7 +29,7 @@ use core::{ffi::c_void, panic::PanicInfo};
 
 /// In case of runtime problems, return an internal error and exit the app
 #[inline]
-#[cfg_attr(test, panic_handler)]
+#[cfg_attr(all(test, not(feature = "host")), panic_handler)]
 pub fn exiting_panic(_info: &PanicInfo) -> ! {
     let mut comm = io::Comm::new();
     comm.reply(io::StatusWords::Panic);
@@ -44,7 +51,7 @@ macro_rules! set_panic {
 
 /// Debug 'print' function that uses ARM semihosting
 /// Prints only strings with no formatting
-#[cfg(feature = "speculos")]
+#[cfg(all(feature = "speculos", not(feature = "host")))]
 pub fn debug_print(s: &str) {
     let p = s.as_bytes().as_ptr();
     for i in 0..s.len() {
@@ -59,6 +66,12 @@ pub fn debug_print(s: &str) {
     }
 }
 
+/// Debug 'print' function, printing to the standard error on host builds
+#[cfg(feature = "host")]
+pub fn debug_print(s: &str) {
+    std::eprint!("{}", s);
+}
+
 /// Custom type used to implement tests
 #[cfg(feature = "speculos")]
 pub struct TestType {
@@ -105,7 +118,7 @@ pub fn sdk_test_runner(tests: &[&TestType]) {
 /// This variant of `assert_eq!()` returns an error
 /// `Err(())` instead of panicking, to prevent tests
 /// from exiting on first failure
-#[cfg(feature = "speculos")]
+#[cfg(any(feature = "speculos", feature = "host"))]
 #[macro_export]
 macro_rules! assert_eq_err {
     ($left:expr, $right:expr) => {{
@@ -120,10 +133,12 @@ macro_rules! assert_eq_err {
     }};
 }
 
+#[cfg(not(feature = "host"))]
 extern "C" {
     fn c_main();
 }
 
+#[cfg(not(feature = "host"))]
 #[link_section = ".boot"]
 #[no_mangle]
 pub extern "C" fn _start() -> ! {
@@ -196,14 +211,14 @@ impl<T> Pic<T> {
     }
 }
 
-#[cfg(test)]
+#[cfg(all(test, not(feature = "host")))]
 #[no_mangle]
 fn sample_main() {
     test_main();
     exit_app(0);
 }
 
-#[cfg(test)]
+#[cfg(all(test, not(feature = "host")))]
 mod tests {
     use super::*;
     use crate::assert_eq_err as assert_eq;
@@ -0,0 +1,60 @@
+//! Mock syscalls for host builds
+//!
+//! With the `host` feature, the crate is not linked against the C SDK. This
+//! module provides host implementations of the syscalls and C globals used by
+//! the pure-logic parts of the SDK, so that they can be tested natively with
+//! `cargo test`:
+//!
+//! ```text
+//! cargo test --lib --features host --target x86_64-unknown-linux-gnu
+//! ```
+//!
+//! NVM writes are simulated by [`nvm::sim`](crate::nvm::sim). Cryptographic
+//! syscalls are not mocked, so the `ecc` and `hash` functions relying on them
+//! can only be tested on the device or Speculos.
+
+use crate::bindings::{bolos_task_status_t, io_seph_app_t};
+use core::cell::Cell;
+use core::ffi::c_void;
+
+std::thread_local! {
+    static RNG_STATE: Cell<u64> = Cell::new(0x2545_f491_4f6c_dd1d);
+}
+
+/// Seeds the mock random number generator, to make a test reproducible.
+/// Each thread has its own generator.
+pub fn seed_rng(seed: u64) {
+    // xorshift state must not be zero
+    RNG_STATE.with(|s| s.set(seed | 1));
+}
+
+/// Deterministic xorshift64* generator standing for the hardware RNG.
+#[no_mangle]
+unsafe extern "C" fn cx_rng_no_throw(buffer: *mut u8, len: u32) {
+    let out = core::slice::from_raw_parts_mut(buffer, len as usize);
+    RNG_STATE.with(|s| {
+        for chunk in out.chunks_mut(8) {
+            let mut x = s.get();
+            x ^= x >> 12;
+            x ^= x << 25;
+            x ^= x >> 27;
+            s.set(x);
+            let r = x.wrapping_mul(0x2545_f491_4f6c_dd1d).to_be_bytes();
+            chunk.copy_from_slice(&r[..chunk.len()]);
+        }
+    });
+}
+
+/// There is no relocation on the host.
+#[no_mangle]
+extern "C" fn pic(link_address: *mut c_void) -> *mut c_void {
+    link_address
+}
+
+#[no_mangle]
+extern "C" fn os_sched_exit(exit_code: bolos_task_status_t) {
+    std::process::exit(exit_code as i32);
+}
+
+#[no_mangle]
+static mut G_io_app: io_seph_app_t = unsafe { core::mem::zeroed() };
@@ -40,12 +40,105 @@
 //! println!("counter value is {}", *counter.get_ref());
 //! ```
 
+#[cfg(not(feature = "host"))]
 use crate::bindings::nvm_write;
+#[cfg(feature = "host")]
+use sim::nvm_write;
 use AtomicStorageElem::{StorageA, StorageB};
 
 // Warning: currently alignment is fixed by magic values everywhere, since
 // rust does not allow using a constant in repr(align(...))
 // This code will work correctly only for the currently set page size of 64.
+const PAGE_SIZE: usize = 64;
+
+/// Types whose memory representation can be read as bytes, which is needed
+/// to compare them with the content of the NVM.
+///
+/// Implemented for integers and arrays of them. Storages of such types have
+/// an `update_changed` method, which skips the writes that would not change
+/// the content of the NVM. Applications can implement it for their own
+/// types to benefit from it.
+///
+/// # Safety
+///
+/// The type must have no padding bytes, so that all of its bytes are
+/// initialized: `#[repr(C)]` structures whose fields are `NoPadding` and
+/// laid out without gaps, nor trailing bytes, are fine.
+///
+/// ```
+/// #[repr(C)]
+/// #[derive(Copy, Clone)]
+/// struct Settings {
+///     counter: u32,
+///     flags: [u8; 4],
+/// }
+///
+/// unsafe impl NoPadding for Settings {}
+/// ```
+pub unsafe trait NoPadding {}
+
+macro_rules! impl_no_padding {
+    ($($t:ty),*) => {
+        $(unsafe impl NoPadding for $t {})*
+    };
+}
+
+impl_no_padding!(u8, u16, u32, u64, u128, usize, i8, i16, i32, i64, i128, isize, bool);
+
+unsafe impl<T: NoPadding, const N: usize> NoPadding for [T; N] {}
+
+/// Returns the memory representation of `value`.
+fn as_bytes<T: NoPadding>(value: &T) -> &[u8] {
+    unsafe {
+        core::slice::from_raw_parts(value as *const T as *const u8, core::mem::size_of::<T>())
+    }
+}
+
+/// Writes `src` to the NVM at `dst`, skipping the Flash pages whose content
+/// is already up to date.
+///
+/// `nvm_write` erases and programs every page it touches, so rewriting a
+/// large object for a small change wears and costs much more than needed.
+/// Here the destination is compared page by page against `src`, and each
+/// run of consecutive dirty pages is written with a single `nvm_write`.
+/// Skipping a write whose content is unchanged does not change the result
+/// of an interrupted update, so this is safe for all the storages below.
+///
+/// # Safety
+///
+/// `dst` must point to `src.len()` bytes of NVM.
+unsafe fn nvm_write_dirty(dst: *const u8, src: &[u8]) {
+    let start = dst as usize;
+    let end = start + src.len();
+    let mut run: Option<usize> = None;
+    let mut addr = start;
+    while addr < end {
+        let chunk_end = core::cmp::min(end, (addr / PAGE_SIZE + 1) * PAGE_SIZE);
+        let current = core::slice::from_raw_parts(addr as *const u8, chunk_end - addr);
+        let dirty = current != &src[addr - start..chunk_end - start];
+        match (run, dirty) {
+            (None, true) => run = Some(addr),
+            (Some(run_start), false) => {
+                nvm_write_run(run_start, &src[run_start - start..addr - start]);
+                run = None;
+            }
+            _ => (),
+        }
+        addr = chunk_end;
+    }
+    if let Some(run_start) = run {
+        nvm_write_run(run_start, &src[run_start - start..]);
+    }
+}
+
+/// Writes `src` to the NVM at address `dst`.
+unsafe fn nvm_write_run(dst: usize, src: &[u8]) {
+    nvm_write(
+        dst as *mut cty::c_void,
+        src.as_ptr() as *const cty::c_void as *mut cty::c_void,
+        src.len() as u32,
+    );
+}
 
 /// Returned when trying to insert data when no more space is available
 pub struct StorageFullError;
@@ -92,6 +185,18 @@ impl<T> AlignedStorage<T> {
     }
 }
 
+impl<T: NoPadding> AlignedStorage<T> {
+    /// Same as [`update`](SingleStorage::update), but only the Flash pages
+    /// which content changes are written, and none if the value is
+    /// unchanged.
+    pub fn update_changed(&mut self, value: &T) {
+        unsafe {
+            nvm_write_dirty(&self.value as *const T as *const u8, as_bytes(value));
+            let mut _dummy = &self.value;
+        }
+    }
+}
+
 impl<T> SingleStorage<T> for AlignedStorage<T> {
     /// Return non-mutable reference to the stored value.
     /// The address is always the same for AlignedStorage.
@@ -150,6 +255,20 @@ impl<T> SafeStorage<T> {
     }
 }
 
+impl<T: NoPadding> SafeStorage<T> {
+    /// Same as [`update`](SingleStorage::update), but nothing is written if
+    /// the value is unchanged, and only the Flash pages of the value which
+    /// content changes are written otherwise.
+    pub fn update_changed(&mut self, value: &T) {
+        if self.is_valid() && as_bytes(self.value.get_ref()) == as_bytes(value) {
+            return;
+        }
+        self.flag.update(&0);
+        self.value.update_changed(value);
+        self.flag.update(&STORAGE_VALID);
+    }
+}
+
 impl<T> SingleStorage<T> for SafeStorage<T> {
     /// Return non-mutable reference to the stored value.
     /// Panic if the storage is not valid (corrupted).
@@ -212,6 +331,30 @@ where
     }
 }
 
+impl<T> AtomicStorage<T>
+where
+    T: Copy + NoPadding,
+{
+    /// Same as [`update`](SingleStorage::update), but nothing is written if
+    /// the value is unchanged, and only the Flash pages of the value which
+    /// content changes are written otherwise.
+    pub fn update_changed(&mut self, value: &T) {
+        if as_bytes(self.get_ref()) == as_bytes(value) {
+            return;
+        }
+        match self.which() {
+            StorageA => {
+                self.storage_b.update_changed(value);
+                self.storage_a.invalidate();
+            }
+            StorageB => {
+                self.storage_a.update_changed(value);
+                self.storage_b.invalidate();
+            }
+        }
+    }
+}
+
 impl<T> SingleStorage<T> for AtomicStorage<T>
 where
     T: Copy,
@@ -239,12 +382,158 @@ where
         }
     }
 }
+/// Record of a [`LogStorage`], occupying its own Flash page(s).
+///
+/// A write reprograms whole pages, from their first byte. The flag is at
+/// the end of the record, so that it is programmed after the rest of its
+/// page: the record cannot be valid with a partially programmed content.
+#[repr(C, align(64))]
+#[derive(Copy, Clone)]
+struct LogRecord<T> {
+    seq: u32,
+    value: T,
+    flag: u8,
+}
+
+/// Non-Volatile data storage with atomic and wear-leveled updates.
+///
+/// Successive values are appended as versioned records to a ring of `PAGES`
+/// records, each in its own Flash page. The current value is the valid
+/// record with the highest sequence number, in serial number arithmetic
+/// so that the order is kept when the number wraps.
+///
+/// An update writes the next record of the ring, which holds the oldest
+/// value, with two `nvm_write` calls on the same page: the record with a
+/// cleared flag, then the flag. Records larger than a page take one more
+/// call, as the last page, which holds the flag, is written first to
+/// invalidate the record. Compared to [`AtomicStorage`], this is two
+/// writes instead of six, and each page is programmed only once every
+/// `PAGES` updates. The current record is never touched, so an interrupted
+/// update leaves the previous value readable. Since the oldest record is
+/// simply overwritten, the ring never needs to be compacted.
+///
+/// This is well suited to values updated very often, such as a counter
+/// incremented on each signature.
+///
+/// # Examples
+///
+/// ```
+/// #[link_section=".nvm_data"]
+/// static mut NONCE: Pic<LogStorage<u32, 8>> = Pic::new(LogStorage::new(&0));
+/// ```
+pub struct LogStorage<T, const PAGES: usize> {
+    records: [LogRecord<T>; PAGES],
+}
+
+impl<T, const PAGES: usize> LogStorage<T, PAGES>
+where
+    T: Copy,
+{
+    /// Create a LogStorage<T, PAGES> initialized with a given value.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `PAGES` is lower than 2, as the current record must never be
+    /// overwritten.
+    pub const fn new(value: &T) -> LogStorage<T, PAGES> {
+        if PAGES < 2 {
+            panic!("LogStorage requires at least 2 pages");
+        }
+        let mut records = [LogRecord {
+            seq: 0,
+            value: *value,
+            flag: 0,
+        }; PAGES];
+        records[0].flag = STORAGE_VALID;
+        records[0].seq = 1;
+        LogStorage { records }
+    }
+
+    /// Returns the index of the current record.
+    ///
+    /// # Panics
+    ///
+    /// Panics if no record is valid (data corruption), although this shall
+    /// not be possible with tearing.
+    fn current(&self) -> usize {
+        let mut current: Option<usize> = None;
+        for (i, record) in self.records.iter().enumerate() {
+            if record.flag == STORAGE_VALID {
+                match current {
+                    // Serial number arithmetic, for the order to hold when
+                    // the sequence number wraps
+                    Some(c) if (record.seq.wrapping_sub(self.records[c].seq) as i32) <= 0 => (),
+                    _ => current = Some(i),
+                }
+            }
+        }
+        match current {
+            Some(c) => c,
+            None => panic!("invalidated log storage"),
+        }
+    }
+}
+
+impl<T, const PAGES: usize> SingleStorage<T> for LogStorage<T, PAGES>
+where
+    T: Copy,
+{
+    /// Return reference to the current value.
+    fn get_ref(&self) -> &T {
+        &self.records[self.current()].value
+    }
+
+    /// Append the value as a new record, overwriting the oldest one.
+    fn update(&mut self, value: &T) {
+        let current = self.current();
+        let next = (current + 1) % PAGES;
+        let record = LogRecord {
+            seq: self.records[current].seq.wrapping_add(1),
+            value: *value,
+            flag: 0,
+        };
+        let dst = &self.records[next] as *const LogRecord<T> as usize;
+        let src = &record as *const LogRecord<T> as usize;
+        let size = core::mem::size_of::<LogRecord<T>>();
+        // Offset of the last page of the record, which holds the flag
+        let last = (size - 1) / PAGE_SIZE * PAGE_SIZE;
+        unsafe {
+            nvm_write(
+                (dst + last) as *mut cty::c_void,
+                (src + last) as *mut cty::c_void,
+                (size - last) as u32,
+            );
+            if last > 0 {
+                nvm_write(
+                    dst as *mut cty::c_void,
+                    src as *mut cty::c_void,
+                    last as u32,
+                );
+            }
+            nvm_write(
+                &self.records[next].flag as *const u8 as *const cty::c_void as *mut cty::c_void,
+                &STORAGE_VALID as *const u8 as *const cty::c_void as *mut cty::c_void,
+                1,
+            );
+        }
+    }
+}
+
 pub struct KeyOutOfRange;
 
+/// Flag of an allocated slot whose item has been updated in place: the
+/// current value of the item is held by the spare slot of the collection.
+const SLOT_MOVED: u8 = 0x5a;
+
+/// Returns true if `flag` marks an allocated slot of a [`Collection`].
+fn is_allocated_flag(flag: u8) -> bool {
+    flag == STORAGE_VALID || flag == SLOT_MOVED
+}
+
 /// A Non-Volatile fixed-size collection of fixed-size items.
-/// Items insertion and deletion are atomic.
-/// Items update is not implemented because the atomicity of this operation
-/// cannot be guaranteed here.
+/// Items insertion, deletion and update are atomic.
+///
+/// An extra spare slot is used to update items in place.
 // We use the term `index` to represent the user-facing number of an element in the collection,
 // and the term `key` to represent the underlying offset at which the element is located in the collection.
 // e.g with `[0, 0, 1, 1, 0, 1, 0]` (with 0s representing free slots and 1s representing allocated slots)
@@ -254,6 +543,7 @@ pub struct KeyOutOfRange;
 pub struct Collection<T, const N: usize> {
     flags: AtomicStorage<[u8; N]>,
     slots: [AlignedStorage<T>; N],
+    spare: AlignedStorage<T>,
 }
 
 impl<T, const N: usize> Collection<T, N>
@@ -264,6 +554,7 @@ where
         Collection {
             flags: AtomicStorage::new(&[0; N]),
             slots: [AlignedStorage::new(value); N],
+            spare: AlignedStorage::new(value),
         }
     }
 
@@ -273,7 +564,16 @@ where
         self.flags
             .get_ref()
             .iter()
-            .position(|&e| e != STORAGE_VALID)
+            .position(|&e| !is_allocated_flag(e))
+    }
+
+    /// Returns the item stored at the allocated `key`.
+    fn slot(&self, key: usize) -> &T {
+        if self.flags.get_ref()[key] == SLOT_MOVED {
+            self.spare.get_ref()
+        } else {
+            self.slots[key].get_ref()
+        }
     }
 
     /// Adds an item in the collection. Returns an error if there is not free
@@ -281,17 +581,23 @@ where
     /// This operation is atomic.
     pub fn add(&mut self, value: &T) -> Result<(), StorageFullError> {
         match self.find_free_slot() {
-            Some(i) => {
-                self.slots[i].update(value);
-                let mut new_flags = *self.flags.get_ref();
-                new_flags[i] = STORAGE_VALID;
-                self.flags.update(&new_flags);
+            Some(key) => {
+                self.add_at(key, value);
                 Ok(())
             }
             None => Err(StorageFullError),
         }
     }
 
+    /// Stores an item in the free slot at `key`.
+    /// This operation is atomic.
+    fn add_at(&mut self, key: usize, value: &T) {
+        self.slots[key].update(value);
+        let mut new_flags = *self.flags.get_ref();
+        new_flags[key] = STORAGE_VALID;
+        self.flags.update_changed(&new_flags);
+    }
+
     /// Returns a boolean representing whether the slot at `key` was allocated or not.
     ///
     /// # Errors
@@ -299,13 +605,7 @@ where
     /// Returns an error if the `key` is out of range.
     fn is_allocated(&self, key: usize) -> Result<bool, KeyOutOfRange> {
         match self.flags.get_ref().get(key) {
-            Some(&byte) => {
-                if byte == STORAGE_VALID {
-                    Ok(true)
-                } else {
-                    Ok(false)
-                }
-            }
+            Some(&byte) => Ok(is_allocated_flag(byte)),
             None => Err(KeyOutOfRange),
         }
     }
@@ -317,7 +617,7 @@ where
 
     /// Returns true if collection is empty
     pub fn is_empty(&self) -> bool {
-        !self.flags.get_ref().iter().any(|v| *v == STORAGE_VALID)
+        !self.flags.get_ref().iter().any(|&v| is_allocated_flag(v))
     }
 
     /// Returns the maximum number of items the collection can store.
@@ -337,7 +637,7 @@ where
             .get_ref()
             .iter()
             .take(len)
-            .fold(0, |acc, &byte| acc + (byte == STORAGE_VALID) as u32) as usize
+            .fold(0, |acc, &byte| acc + is_allocated_flag(byte) as u32) as usize
     }
 
     /// Returns the `key` of an item in the internal storage, given the `index`
@@ -372,7 +672,7 @@ where
     /// * `index` - Item index
     pub fn get(&self, index: usize) -> Option<&T> {
         match self.index_to_key(index) {
-            Some(key) => Some(self.slots[key].get_ref()),
+            Some(key) => Some(self.slot(key)),
             None => None,
         }
     }
@@ -388,15 +688,95 @@ where
     /// Panics if `index` is out of bounds.
     pub fn remove(&mut self, index: usize) {
         let key = self.index_to_key(index).unwrap();
+        self.remove_at(key);
+    }
+
+    /// Frees the slot at `key`.
+    /// This operation is atomic.
+    fn remove_at(&mut self, key: usize) {
         let mut new_flags = *self.flags.get_ref();
         new_flags[key] = 0;
-        self.flags.update(&new_flags);
+        self.flags.update_changed(&new_flags);
+    }
+
+    /// Replaces the item located at `index` in the collection. The item keeps
+    /// its index, and the update works even if the collection is full.
+    /// This operation is atomic.
+    ///
+    /// If a slot next to the item is free, the new value is written in it,
+    /// then the old slot is freed and the new one allocated with a single
+    /// update of the flags. Otherwise, the new value is written in the spare
+    /// slot, and the item is flagged to be read from it. It stays there until
+    /// its next update, which writes its own slot and clears the flag.
+    /// Either way, an update costs one value write and one update of the
+    /// flags, like an add. When the spare slot holds another item, this item
+    /// is first written back to its own slot, which costs one more of each.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `index` is out of bounds.
+    pub fn update(&mut self, index: usize, value: &T) {
+        let key = self.index_to_key(index).unwrap();
+        self.update_at(key, value);
+    }
+
+    /// Replaces the item at the allocated `key`, and returns the key it is
+    /// stored at afterwards.
+    /// This operation is atomic.
+    fn update_at(&mut self, key: usize, value: &T) -> usize {
+        let flags = *self.flags.get_ref();
+        let is_free = |k: usize| k < N && !is_allocated_flag(flags[k]);
+        // Moving the item to a free neighbour does not change the order
+        let neighbour = if key > 0 && is_free(key - 1) {
+            Some(key - 1)
+        } else if is_free(key + 1) {
+            Some(key + 1)
+        } else {
+            None
+        };
+        let mut new_flags = flags;
+        match neighbour {
+            Some(new_key) => {
+                self.slots[new_key].update(value);
+                new_flags[key] = 0;
+                new_flags[new_key] = STORAGE_VALID;
+                self.flags.update_changed(&new_flags);
+                new_key
+            }
+            None if flags[key] == SLOT_MOVED => {
+                // The slot of the item is unused while it is moved
+                self.slots[key].update(value);
+                new_flags[key] = STORAGE_VALID;
+                self.flags.update_changed(&new_flags);
+                key
+            }
+            None => {
+                self.restore_moved();
+                let mut new_flags = *self.flags.get_ref();
+                self.spare.update(value);
+                new_flags[key] = SLOT_MOVED;
+                self.flags.update_changed(&new_flags);
+                key
+            }
+        }
+    }
+
+    /// Copies the item held by the spare slot back to its own slot, if any,
+    /// to free the spare slot.
+    fn restore_moved(&mut self) {
+        let mut new_flags = *self.flags.get_ref();
+        if let Some(key) = new_flags.iter().position(|&f| f == SLOT_MOVED) {
+            let value = *self.spare.get_ref();
+            self.slots[key].update(&value);
+            new_flags[key] = STORAGE_VALID;
+            self.flags.update_changed(&new_flags);
+        }
     }
 
     /// Removes all the items from the collection.
     /// This operation is atomic.
     pub fn clear(&mut self) {
-        self.flags.update(&[0; N]);
+        self.flags.update_changed(&[0; N]);
     }
 }
 
@@ -434,8 +814,844 @@ where
             let is_allocated = self.container.is_allocated(self.next_key).ok()?;
             self.next_key += 1;
             if is_allocated {
-                return Some(self.container.slots[self.next_key - 1].get_ref());
+                return Some(self.container.slot(self.next_key - 1));
+            }
+        }
+    }
+}
+
+/// RAM index of the allocated slots of a [`Collection`], giving fast access
+/// to items by index.
+///
+/// [`Collection::get`] scans the allocation flags on each call, which makes
+/// iterating with `get(i)` quadratic. This index keeps the allocation flags
+/// as a bitmap of `W` 32-bit words, with the number of allocated slots
+/// before each word (its rank). Finding the key of an index is then a binary
+/// search over the ranks, and finding a free slot is a scan of `W` words.
+/// `W` must be at least `N / 32` rounded up: 8 words (48 bytes of RAM) for
+/// a collection of 256 items.
+///
+/// The index is built on first access, and kept up to date by its own
+/// modification methods. It mutably borrows the collection, so the
+/// collection cannot be modified behind its back.
+///
+/// # Examples
+///
+/// ```
+/// let mut index = CollectionIndex::<_, 256, 8>::new(unsafe { ADDRESSES.get_mut() });
+/// for i in 0..index.len() {
+///     let address = index.get(i).unwrap();
+///     ...
+/// }
+/// ```
+pub struct CollectionIndex<'a, T, const N: usize, const W: usize> {
+    collection: &'a mut Collection<T, N>,
+    bitmap: [u32; W],
+    ranks: [u16; W],
+    built: bool,
+}
+
+impl<'a, T, const N: usize, const W: usize> CollectionIndex<'a, T, N, W>
+where
+    T: Copy,
+{
+    /// # Panics
+    ///
+    /// Panics if `W` is too small for `N` slots.
+    pub fn new(collection: &'a mut Collection<T, N>) -> Self {
+        assert!(W * 32 >= N && N <= u16::MAX as usize);
+        CollectionIndex {
+            collection,
+            bitmap: [0; W],
+            ranks: [0; W],
+            built: false,
+        }
+    }
+
+    /// Builds the index from the allocation flags, if not done yet.
+    fn build(&mut self) {
+        if self.built {
+            return;
+        }
+        for (key, &flag) in self.collection.flags.get_ref().iter().enumerate() {
+            if is_allocated_flag(flag) {
+                self.bitmap[key / 32] |= 1 << (key % 32);
             }
         }
+        self.update_ranks(0);
+        self.built = true;
+    }
+
+    /// Recomputes the ranks of the words following the word `from`.
+    fn update_ranks(&mut self, from: usize) {
+        for w in from + 1..W {
+            self.ranks[w] = self.ranks[w - 1] + self.bitmap[w - 1].count_ones() as u16;
+        }
+    }
+
+    /// Returns the number of items in the collection.
+    pub fn len(&mut self) -> usize {
+        self.build();
+        self.ranks[W - 1] as usize + self.bitmap[W - 1].count_ones() as usize
+    }
+
+    /// Returns true if the collection is empty.
+    pub fn is_empty(&mut self) -> bool {
+        self.len() == 0
+    }
+
+    /// Returns the key of the item at `index`, or None if `index` is out of
+    /// bounds.
+    fn index_to_key(&mut self, index: usize) -> Option<usize> {
+        if index >= self.len() {
+            return None;
+        }
+        // Last word with less than `index` allocated slots before it: the
+        // item is in this word.
+        let w = self.ranks.partition_point(|&rank| rank as usize <= index) - 1;
+        let mut bits = self.bitmap[w];
+        for _ in 0..index - self.ranks[w] as usize {
+            bits &= bits - 1;
+        }
+        Some(w * 32 + bits.trailing_zeros() as usize)
+    }
+
+    /// Returns reference to an item, or None if the index is out of bounds.
+    pub fn get(&mut self, index: usize) -> Option<&T> {
+        let key = self.index_to_key(index)?;
+        Some(self.collection.slot(key))
+    }
+
+    /// Returns the key of the first free slot, or None if all slots are
+    /// allocated.
+    fn find_free_slot(&mut self) -> Option<usize> {
+        self.build();
+        let w = self.bitmap.iter().position(|&bits| bits != u32::MAX)?;
+        let key = w * 32 + self.bitmap[w].trailing_ones() as usize;
+        if key < N {
+            Some(key)
+        } else {
+            None
+        }
+    }
+
+    /// Adds an item in the collection. Returns an error if there is not free
+    /// slots.
+    /// This operation is atomic.
+    pub fn add(&mut self, value: &T) -> Result<(), StorageFullError> {
+        let key = self.find_free_slot().ok_or(StorageFullError)?;
+        self.collection.add_at(key, value);
+        self.bitmap[key / 32] |= 1 << (key % 32);
+        self.update_ranks(key / 32);
+        Ok(())
+    }
+
+    /// Replaces the item located at `index` in the collection. See
+    /// [`Collection::update`].
+    ///
+    /// # Panics
+    ///
+    /// Panics if `index` is out of bounds.
+    pub fn update(&mut self, index: usize, value: &T) {
+        let key = self.index_to_key(index).unwrap();
+        let new_key = self.collection.update_at(key, value);
+        if new_key != key {
+            self.bitmap[key / 32] &= !(1 << (key % 32));
+            self.bitmap[new_key / 32] |= 1 << (new_key % 32);
+            self.update_ranks(key.min(new_key) / 32);
+        }
+    }
+
+    /// Removes the item located at `index` from the collection.
+    ///
+    /// # Panics
+    ///
+    /// Panics if `index` is out of bounds.
+    pub fn remove(&mut self, index: usize) {
+        let key = self.index_to_key(index).unwrap();
+        self.collection.remove_at(key);
+        self.bitmap[key / 32] &= !(1 << (key % 32));
+        self.update_ranks(key / 32);
+    }
+}
+
+/// Length of the header of a journal entry: data length and destination
+/// address.
+const JOURNAL_ENTRY_HEADER_LEN: usize = 2 + core::mem::size_of::<usize>();
+
+/// Non-Volatile journal, used by [`Transaction`] to update several storages
+/// atomically.
+///
+/// The journal holds up to `SIZE` bytes of staged updates, including a
+/// header of a few bytes per update. It must be declared in NVM like any
+/// other storage, and [`recover`](Journal::recover) must be called when the
+/// application starts, before reading the storages it updates.
+///
+/// # Examples
+///
+/// ```
+/// #[link_section=".nvm_data"]
+/// static mut JOURNAL: Pic<Journal<128>> = Pic::new(Journal::new());
+/// #[link_section=".nvm_data"]
+/// static mut SETTINGS: Pic<AlignedStorage<Settings>> = Pic::new(AlignedStorage::new(DEFAULT));
+/// #[link_section=".nvm_data"]
+/// static mut COUNTER: Pic<AlignedStorage<u32>> = Pic::new(AlignedStorage::new(0));
+///
+/// let journal = unsafe { JOURNAL.get_mut() };
+/// journal.recover();
+/// let mut tx = Transaction::new(journal);
+/// tx.update(unsafe { SETTINGS.get_mut() }, &new_settings)?;
+/// tx.update(unsafe { COUNTER.get_mut() }, &(counter + 1))?;
+/// tx.commit();
+/// ```
+pub struct Journal<const SIZE: usize> {
+    // Flag and data are in distinct pages, so writing one cannot corrupt the
+    // other.
+    committed: AlignedStorage<u8>,
+    data: AlignedStorage<[u8; SIZE]>,
+}
+
+impl<const SIZE: usize> Journal<SIZE> {
+    pub const fn new() -> Journal<SIZE> {
+        Journal {
+            committed: AlignedStorage::new(0),
+            data: AlignedStorage::new([0; SIZE]),
+        }
+    }
+
+    /// Completes a transaction whose commit has been interrupted. Does
+    /// nothing if no commit was in progress.
+    pub fn recover(&mut self) {
+        if *self.committed.get_ref() == STORAGE_VALID {
+            self.apply();
+            self.committed.update(&0);
+        }
+    }
+
+    /// Writes all the journal entries to their destinations. This is
+    /// idempotent, so it can be repeated if interrupted.
+    fn apply(&mut self) {
+        let data = self.data.get_ref();
+        let mut pos = 0;
+        while pos + JOURNAL_ENTRY_HEADER_LEN <= SIZE {
+            let len = u16::from_le_bytes([data[pos], data[pos + 1]]) as usize;
+            if len == 0 {
+                break;
+            }
+            let mut addr = [0u8; core::mem::size_of::<usize>()];
+            addr.copy_from_slice(&data[pos + 2..pos + JOURNAL_ENTRY_HEADER_LEN]);
+            let value = &data[pos + JOURNAL_ENTRY_HEADER_LEN..];
+            unsafe {
+                nvm_write_dirty(usize::from_le_bytes(addr) as *const u8, &value[..len]);
+            }
+            pos += JOURNAL_ENTRY_HEADER_LEN + len;
+        }
+    }
+}
+
+impl<const SIZE: usize> Default for Journal<SIZE> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// Set of storage updates committed atomically.
+///
+/// Updates are staged in RAM, then [`commit`](Transaction::commit) writes
+/// them all to the journal in a single write and marks the journal as
+/// committed, before writing them to their destinations. If this last step
+/// is interrupted, [`Journal::recover`] completes it on next start. Either
+/// all the updates of a transaction are applied, or none of them.
+///
+/// Committing N updates costs N + 3 `nvm_write` calls, against 6 per update
+/// with [`AtomicStorage`]. Since the journal brings atomicity, destinations
+/// can be plain [`AlignedStorage`], which also take half the space.
+pub struct Transaction<'a, const SIZE: usize> {
+    journal: &'a mut Journal<SIZE>,
+    staged: [u8; SIZE],
+    len: usize,
+}
+
+impl<'a, const SIZE: usize> Transaction<'a, SIZE> {
+    /// Starts a transaction, after completing any interrupted one.
+    pub fn new(journal: &'a mut Journal<SIZE>) -> Transaction<'a, SIZE> {
+        journal.recover();
+        Transaction {
+            journal,
+            staged: [0; SIZE],
+            len: 0,
+        }
+    }
+
+    /// Stages the update of `storage` with `value`. The stored value is
+    /// unchanged until the transaction is committed.
+    ///
+    /// Returns an error if the journal is too small to hold this update.
+    pub fn update<T>(
+        &mut self,
+        storage: &mut AlignedStorage<T>,
+        value: &T,
+    ) -> Result<(), StorageFullError> {
+        let size = core::mem::size_of::<T>();
+        let end = self.len + JOURNAL_ENTRY_HEADER_LEN + size;
+        if size == 0 || size > u16::MAX as usize || end > SIZE {
+            return Err(StorageFullError);
+        }
+        let addr = storage.get_ref() as *const T as usize;
+        let entry = &mut self.staged[self.len..end];
+        entry[..2].copy_from_slice(&(size as u16).to_le_bytes());
+        entry[2..JOURNAL_ENTRY_HEADER_LEN].copy_from_slice(&addr.to_le_bytes());
+        // Raw copy, as the value may contain padding: the staged entries are
+        // only passed to `nvm_write`, never read as bytes.
+        unsafe {
+            core::ptr::copy_nonoverlapping(
+                value as *const T as *const u8,
+                entry[JOURNAL_ENTRY_HEADER_LEN..].as_mut_ptr(),
+                size,
+            );
+        }
+        self.len = end;
+        Ok(())
+    }
+
+    /// Atomically applies all the staged updates.
+    pub fn commit(self) {
+        if self.len == 0 {
+            return;
+        }
+        self.journal.data.update(&self.staged);
+        self.journal.committed.update(&STORAGE_VALID);
+        self.journal.apply();
+        self.journal.committed.update(&0);
+    }
+}
+
+/// NVM writes statistics, to detect pathological write patterns.
+///
+/// Enabled with the `nvm_stats` feature. Every `nvm_write` syscall, including
+/// the ones made from C code, is recorded by a hook in `syscalls.c`: the
+/// number of writes and bytes written, and the number of times each Flash
+/// page has been programmed. Up to [`MAX_PAGES`](stats::MAX_PAGES) distinct
+/// pages are tracked, further pages are only counted as untracked.
+///
+/// The statistics are returned by a diagnostics APDU, which the application
+/// opts in to with
+/// [`Comm::enable_nvm_stats`](crate::io::Comm::enable_nvm_stats), choosing
+/// its class and instruction (`B0 F0` by default, see [`CLA`](stats::CLA)
+/// and [`INS`](stats::INS)). This APDU is then answered by
+/// [`Comm::next_event`](crate::io::Comm::next_event) without reaching the
+/// application. The response is made of big-endian `u32`: writes count,
+/// bytes written, pages programmed, untracked page writes, then an
+/// (address, count) pair per tracked page, as many as the APDU buffer can
+/// hold.
+///
+/// There is no clock readable during a syscall (the ticker is only serviced
+/// by the event loop), so the latency is given as the number of programmed
+/// pages, which is what the duration of `nvm_write` depends on.
+#[cfg(feature = "nvm_stats")]
+pub mod stats {
+    use super::PAGE_SIZE;
+    use crate::io::{Comm, StatusWords};
+
+    /// Default class of the diagnostics APDU.
+    pub const CLA: u8 = 0xb0;
+    /// Default instruction of the diagnostics APDU.
+    pub const INS: u8 = 0xf0;
+    /// Maximum number of distinct pages tracked.
+    pub const MAX_PAGES: usize = 16;
+
+    #[derive(Copy, Clone)]
+    pub struct PageStats {
+        pub address: usize,
+        pub count: u32,
+    }
+
+    pub struct Stats {
+        pub writes: u32,
+        pub bytes: u32,
+        pub pages: u32,
+        pub untracked: u32,
+        pub tracked: usize,
+        pub page_stats: [PageStats; MAX_PAGES],
+    }
+
+    static mut STATS: Stats = Stats {
+        writes: 0,
+        bytes: 0,
+        pages: 0,
+        untracked: 0,
+        tracked: 0,
+        page_stats: [PageStats {
+            address: 0,
+            count: 0,
+        }; MAX_PAGES],
+    };
+
+    /// Returns the statistics recorded since the application started.
+    pub fn get() -> &'static Stats {
+        unsafe { &STATS }
+    }
+
+    /// Resets all the statistics.
+    pub fn reset() {
+        unsafe {
+            STATS.writes = 0;
+            STATS.bytes = 0;
+            STATS.pages = 0;
+            STATS.untracked = 0;
+            STATS.tracked = 0;
+        }
+    }
+
+    impl Stats {
+        /// Returns the statistics of the tracked pages.
+        pub fn page_stats(&self) -> &[PageStats] {
+            &self.page_stats[..self.tracked]
+        }
+
+        fn record(&mut self, address: usize, len: usize) {
+            self.writes = self.writes.wrapping_add(1);
+            self.bytes = self.bytes.wrapping_add(len as u32);
+            if len == 0 {
+                return;
+            }
+            let first = address / PAGE_SIZE;
+            let last = (address + len - 1) / PAGE_SIZE;
+            for page in first..=last {
+                self.pages = self.pages.wrapping_add(1);
+                let address = page * PAGE_SIZE;
+                match self.page_stats().iter().position(|p| p.address == address) {
+                    Some(i) => self.page_stats[i].count += 1,
+                    None if self.tracked < MAX_PAGES => {
+                        self.page_stats[self.tracked] = PageStats { address, count: 1 };
+                        self.tracked += 1;
+                    }
+                    None => self.untracked = self.untracked.wrapping_add(1),
+                }
+            }
+        }
+    }
+
+    /// Called by `nvm_write` after each write.
+    #[no_mangle]
+    extern "C" fn nvm_write_hook(dst_adr: *mut cty::c_void, src_len: cty::c_uint) {
+        unsafe { STATS.record(dst_adr as usize, src_len as usize) };
+    }
+
+    /// Replies to the diagnostics APDU. The tracked pages which do not fit
+    /// in the APDU buffer are left out.
+    pub(crate) fn reply<const N: usize>(comm: &mut Comm<N>) {
+        // Keep room for the status word
+        let room = (comm.capacity() - 2).saturating_sub(comm.tx);
+        if room < 16 {
+            comm.reply(StatusWords::BadLen);
+            return;
+        }
+        let stats = get();
+        for value in &[stats.writes, stats.bytes, stats.pages, stats.untracked] {
+            comm.append(&value.to_be_bytes());
+        }
+        let pages = stats.page_stats();
+        let count = core::cmp::min(pages.len(), (room - 16) / 8);
+        for page in &pages[..count] {
+            comm.append(&(page.address as u32).to_be_bytes());
+            comm.append(&page.count.to_be_bytes());
+        }
+        comm.reply(StatusWords::Ok);
+    }
+}
+
+/// Host-side simulation of the NVM, with power cut injection.
+///
+/// Enabled with the `host` feature, which builds the crate for the host
+/// instead of the device. The storages are then plain memory, and
+/// `nvm_write` is simulated by copying bytes into it.
+///
+/// As on the device, each Flash page touched by a write is erased, then
+/// programmed again from its first byte, with its previous content outside
+/// the written range. A power cut can be scheduled at any of these cut
+/// points:
+/// - before a write starts, which leaves its pages untouched;
+/// - after any number of bytes of a page have been programmed, which leaves
+///   the rest of the page erased (filled with `0xff`), including the bytes
+///   outside the written range.
+///
+/// The execution is then stopped by unwinding with a
+/// [`PowerCut`](sim::PowerCut) payload, and the memory is in the state it
+/// would have after a reboot of the device. Like on the device, the written
+/// memory must be made of whole pages, which is the case of the storages of
+/// this module since they are page-aligned.
+///
+/// [`check_power_cuts`](sim::check_power_cuts) runs an operation with a cut
+/// at each of its cut points, to check that the invariants of a storage hold
+/// whatever the cut point. It can be run with:
+///
+/// ```text
+/// cargo test --lib --features host --target x86_64-unknown-linux-gnu
+/// ```
+#[cfg(feature = "host")]
+pub mod sim {
+    use super::PAGE_SIZE;
+    use core::cell::Cell;
+    use core::mem::MaybeUninit;
+    use std::panic::AssertUnwindSafe;
+
+    std::thread_local! {
+        /// Number of cut points which can still be passed before the power
+        /// cut.
+        static BUDGET: Cell<Option<usize>> = Cell::new(None);
+        /// Number of cut points passed since the last call to
+        /// `restore_power`.
+        static PASSED: Cell<usize> = Cell::new(0);
+    }
+
+    /// Payload of the unwinding which simulates a power cut.
+    pub struct PowerCut;
+
+    /// Passes `n` cut points. Returns the number of them passed before the
+    /// scheduled power cut, if it happens within them.
+    fn pass(n: usize) -> Option<usize> {
+        let cut = match BUDGET.with(|b| b.get()) {
+            Some(budget) if budget < n => {
+                BUDGET.with(|b| b.set(None));
+                Some(budget)
+            }
+            Some(budget) => {
+                BUDGET.with(|b| b.set(Some(budget - n)));
+                None
+            }
+            None => None,
+        };
+        PASSED.with(|p| p.set(p.get() + cut.unwrap_or(n)));
+        cut
+    }
+
+    fn cut_power() -> ! {
+        std::panic::resume_unwind(std::boxed::Box::new(PowerCut))
+    }
+
+    /// Simulated `nvm_write` syscall.
+    ///
+    /// Bytes are copied without being read as `u8`, since the source may
+    /// contain padding, like for the real syscall.
+    ///
+    /// # Safety
+    ///
+    /// `src_adr` must be valid for reads of `src_len` bytes. `dst_adr` must
+    /// be valid for writes of `src_len` bytes and must not overlap the
+    /// source. On a power cut, the whole `PAGE_SIZE` pages spanned by the
+    /// destination are read and rewritten, so they must also be valid for
+    /// reads and writes, as they are for storages aligned on pages.
+    pub unsafe fn nvm_write(dst_adr: *mut cty::c_void, src_adr: *mut cty::c_void, src_len: u32) {
+        if pass(1).is_some() {
+            cut_power();
+        }
+        let start = dst_adr as usize;
+        let end = start + src_len as usize;
+        let mut addr = start;
+        while addr < end {
+            let page = addr - addr % PAGE_SIZE;
+            let chunk_end = core::cmp::min(end, page + PAGE_SIZE);
+            let src = (src_adr as *const u8).add(addr - start);
+            match pass(PAGE_SIZE) {
+                None => core::ptr::copy_nonoverlapping(src, addr as *mut u8, chunk_end - addr),
+                Some(programmed) => {
+                    // The page has been erased, then only partially programmed
+                    // with its new content.
+                    let mut content = [MaybeUninit::<u8>::uninit(); PAGE_SIZE];
+                    let content = content.as_mut_ptr() as *mut u8;
+                    core::ptr::copy_nonoverlapping(page as *const u8, content, PAGE_SIZE);
+                    core::ptr::copy_nonoverlapping(src, content.add(addr - page), chunk_end - addr);
+                    core::ptr::write_bytes(page as *mut u8, 0xff, PAGE_SIZE);
+                    core::ptr::copy_nonoverlapping(content, page as *mut u8, programmed);
+                    cut_power();
+                }
+            }
+            addr = chunk_end;
+        }
+    }
+
+    /// Schedules a power cut after `points` cut points have been passed. The
+    /// write which reaches this limit unwinds with a [`PowerCut`] payload.
+    pub fn cut_power_after(points: usize) {
+        BUDGET.with(|b| b.set(Some(points)));
+        PASSED.with(|p| p.set(0));
+    }
+
+    /// Restores power after a simulated cut, or cancels a scheduled cut.
+    /// Returns the number of cut points passed since the previous call to
+    /// [`cut_power_after`] or `restore_power`.
+    pub fn restore_power() -> usize {
+        BUDGET.with(|b| b.set(None));
+        PASSED.with(|p| p.replace(0))
+    }
+
+    /// Runs `op` on a fresh state returned by `setup`, once with a power cut
+    /// at each of its cut points, then once without any cut. `check` is
+    /// called after each run with power restored, to simulate the reboot and
+    /// check the invariants. Its second argument tells if `op` has been
+    /// completed without power cut.
+    ///
+    /// Returns the number of runs.
+    pub fn check_power_cuts<S, F, G, H>(mut setup: F, mut op: G, mut check: H) -> usize
+    where
+        F: FnMut() -> S,
+        G: FnMut(&mut S),
+        H: FnMut(&mut S, bool),
+    {
+        let mut state = setup();
+        restore_power();
+        op(&mut state);
+        let total = restore_power();
+        check(&mut state, true);
+        for cut in 0..total {
+            let mut state = setup();
+            cut_power_after(cut);
+            let result = std::panic::catch_unwind(AssertUnwindSafe(|| op(&mut state)));
+            restore_power();
+            match result {
+                Err(payload) if !payload.is::<PowerCut>() => std::panic::resume_unwind(payload),
+                _ => (),
+            }
+            check(&mut state, false);
+        }
+        total + 1
+    }
+}
+
+#[cfg(all(test, feature = "host"))]
+mod host_tests {
+    use super::sim::check_power_cuts;
+    use super::*;
+
+    #[test]
+    fn atomic_storage_power_cuts() {
+        let runs = check_power_cuts(
+            || Box::new(AtomicStorage::new(&[1u8; 100])),
+            |s| s.update(&[2; 100]),
+            |s, completed| {
+                let value = *s.get_ref();
+                assert!(value == [2; 100] || (!completed && value == [1; 100]));
+                s.update(&[3; 100]);
+                assert_eq!(*s.get_ref(), [3; 100]);
+            },
+        );
+        assert!(runs > 100);
+    }
+
+    #[test]
+    fn update_changed() {
+        use super::sim::restore_power;
+        // Types with padding are stored with plain writes
+        let mut padded = Box::new(AtomicStorage::new(&(1u8, 2u32)));
+        padded.update(&(3, 4));
+        assert_eq!(*padded.get_ref(), (3, 4));
+        let mut s = Box::new(AtomicStorage::new(&[1u8; 100]));
+        restore_power();
+        s.update_changed(&[1; 100]);
+        assert_eq!(restore_power(), 0);
+        s.update(&[1; 100]);
+        assert!(restore_power() > 0);
+    }
+
+    #[test]
+    fn log_storage_power_cuts() {
+        check_power_cuts(
+            || {
+                let mut s = Box::new(LogStorage::<u32, 4>::new(&0));
+                for i in 1..6 {
+                    s.update(&i);
+                }
+                s
+            },
+            |s| s.update(&6),
+            |s, completed| {
+                let value = *s.get_ref();
+                assert!(value == 6 || (!completed && value == 5));
+                s.update(&7);
+                assert_eq!(*s.get_ref(), 7);
+            },
+        );
+    }
+
+    #[test]
+    fn log_storage_seq_wrap() {
+        let mut s = Box::new(LogStorage::<u32, 4>::new(&0));
+        s.records[0].seq = u32::MAX - 2;
+        for i in 1..10 {
+            s.update(&i);
+            assert_eq!(*s.get_ref(), i);
+        }
+    }
+
+    #[test]
+    fn large_log_storage_power_cuts() {
+        // Records spanning several pages
+        check_power_cuts(
+            || {
+                let mut s = Box::new(LogStorage::<[u8; 100], 3>::new(&[0; 100]));
+                s.update(&[1; 100]);
+                s
+            },
+            |s| s.update(&[2; 100]),
+            |s, completed| {
+                let value = *s.get_ref();
+                assert!(value == [2; 100] || (!completed && value == [1; 100]));
+                s.update(&[3; 100]);
+                assert_eq!(*s.get_ref(), [3; 100]);
+            },
+        );
+    }
+
+    #[test]
+    fn power_cut_points() {
+        // A cut at a write boundary leaves the next page untouched, a cut in
+        // a page leaves the whole page erased after the programmed bytes
+        let setup = || {
+            Box::new([
+                AlignedStorage::new([1u8; 64]),
+                AlignedStorage::new([1u8; 64]),
+            ])
+        };
+        let op = |s: &mut Box<[AlignedStorage<[u8; 64]>; 2]>| {
+            let mut value = [1u8; 64];
+            value[10] = 2;
+            s[0].update(&value);
+            s[1].update(&value);
+        };
+        let mut states = Vec::new();
+        let runs = check_power_cuts(setup, op, |s, _| {
+            states.push((*s[0].get_ref(), *s[1].get_ref()))
+        });
+        // One boundary and one point per programmed byte, for each write
+        assert_eq!(runs, 2 * (1 + PAGE_SIZE) + 1);
+        let mut updated = [1u8; 64];
+        updated[10] = 2;
+        let mut erased = [0xffu8; 64];
+        erased[..5].copy_from_slice(&[1; 5]);
+        assert!(states.contains(&(updated, [1; 64])));
+        assert!(states.contains(&(erased, [1; 64])));
+        assert!(states.contains(&(updated, erased)));
+    }
+
+    fn items<const N: usize>(c: &Collection<u32, N>) -> Vec<u32> {
+        c.into_iter().copied().collect()
+    }
+
+    fn collection() -> Box<Collection<u32, 8>> {
+        let mut c = Box::new(Collection::new(0));
+        for i in 1..4 {
+            assert!(c.add(&i).is_ok());
+        }
+        c
+    }
+
+    #[test]
+    fn collection_power_cuts() {
+        type Op = fn(&mut Collection<u32, 8>);
+        let ops: [(Op, &[u32]); 4] = [
+            (|c| assert!(c.add(&4).is_ok()), &[1, 2, 3, 4]),
+            (|c| c.update(1, &9), &[1, 9, 3]),
+            (|c| c.update(2, &9), &[1, 2, 9]),
+            (|c| c.remove(0), &[2, 3]),
+        ];
+        for (op, expected) in ops.iter() {
+            check_power_cuts(
+                collection,
+                |c| op(c),
+                |c, completed| {
+                    let before = items(c);
+                    assert!(before == *expected || (!completed && before == [1, 2, 3]));
+                    // An interrupted in-place update must not prevent the
+                    // next ones
+                    c.update(0, &7);
+                    let after = items(c);
+                    assert_eq!(after[0], 7);
+                    assert_eq!(after[1..], before[1..]);
+                },
+            );
+        }
+    }
+
+    #[test]
+    fn full_collection_update() {
+        let full = || {
+            let mut c = Box::new(Collection::<u32, 3>::new(0));
+            for i in 1..4 {
+                assert!(c.add(&i).is_ok());
+            }
+            c
+        };
+        check_power_cuts(
+            full,
+            |c| c.update(1, &9),
+            |c, completed| {
+                let items = items(c);
+                assert!(items == [1, 9, 3] || (!completed && items == [1, 2, 3]));
+            },
+        );
+        let moved = || {
+            let mut c = full();
+            c.update(1, &9);
+            c
+        };
+        // The moved item is written back to its own slot
+        check_power_cuts(
+            moved,
+            |c| c.update(1, &7),
+            |c, completed| {
+                let items = items(c);
+                assert!(items == [1, 7, 3] || (!completed && items == [1, 9, 3]));
+            },
+        );
+        // The spare slot is freed for another item
+        check_power_cuts(
+            moved,
+            |c| c.update(0, &8),
+            |c, completed| {
+                let before = items(c);
+                assert!(before == [8, 9, 3] || (!completed && before == [1, 9, 3]));
+                c.update(1, &7);
+                assert_eq!(items(c), [before[0], 7, 3]);
+            },
+        );
+        let mut c = full();
+        let mut index = CollectionIndex::<_, 3, 1>::new(&mut c);
+        for i in 0..3 {
+            index.update(i, &(10 + i as u32));
+        }
+        assert_eq!(index.len(), 3);
+        assert_eq!(items(&c), [10, 11, 12]);
+    }
+
+    #[repr(C)]
+    struct JournalState {
+        journal: Journal<128>,
+        a: AlignedStorage<u32>,
+        b: AlignedStorage<[u8; 80]>,
+    }
+
+    #[test]
+    fn journal_power_cuts() {
+        check_power_cuts(
+            || {
+                Box::new(JournalState {
+                    journal: Journal::new(),
+                    a: AlignedStorage::new(1),
+                    b: AlignedStorage::new([1; 80]),
+                })
+            },
+            |s| {
+                let mut tx = Transaction::new(&mut s.journal);
+                assert!(tx.update(&mut s.a, &2).is_ok());
+                assert!(tx.update(&mut s.b, &[2; 80]).is_ok());
+                tx.commit();
+            },
+            |s, completed| {
+                s.journal.recover();
+                let values = (*s.a.get_ref(), *s.b.get_ref());
+                assert!(values == (2, [2; 80]) || (!completed && values == (1, [1; 80])));
+            },
+        );
     }
 }
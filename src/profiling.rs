@@ -0,0 +1,136 @@
+//! Profiling markers
+//!
+//! Enabled with the `profiling` feature, which requires Speculos. Each marker
+//! is emitted as a semihosting record when a profiled section begins or ends:
+//!
+//! ```text
+//! @P B 0001 00000000 000000000a3f52c1
+//! @P E 0001 00000000 000000000a3f9e07
+//! ```
+//!
+//! with `B` or `E` for the beginning or the end, then the marker id, an
+//! argument and a timestamp, in hexadecimal. The timestamp is the tick count
+//! returned by the `SYS_ELAPSED` semihosting call, in nanoseconds on
+//! Speculos, and is omitted if the call is not supported.
+//! `tools/profile_trace.py` records the output of Speculos and turns it into
+//! a trace-event JSON file or into folded stacks for flame graphs.
+//!
+//! The SDK profiles the event loop, the seproxyhal handlers, the transmission
+//! of responses and every cryptographic syscall (through a hook in
+//! `syscalls.c`, the argument being the syscall id). Applications can profile
+//! their own sections with ids from [`USER`] upwards:
+//!
+//! ```
+//! use nanos_sdk::profiling;
+//!
+//! const PARSE_TX: u16 = profiling::USER;
+//!
+//! let _scope = profiling::scope(PARSE_TX, 0);
+//! parse(&tx);
+//! // The end of the section is recorded when `_scope` is dropped
+//! ```
+//!
+//! Emitting a record takes two semihosting calls. Their cost is included in
+//! the timings, so very short and frequent sections are not worth profiling;
+//! this is why PIC address translation is not instrumented.
+
+/// [`Comm::next_event`](crate::io::Comm::next_event)
+pub const NEXT_EVENT: u16 = 0x0001;
+/// Waiting for and reading a message from the MCU
+pub const SEPH_RECV: u16 = 0x0002;
+/// USB event handling
+pub const USB_EVENT: u16 = 0x0003;
+/// USB endpoint transfer event handling, including HID reassembly
+pub const USB_XFER_EVENT: u16 = 0x0004;
+/// Raw APDU event handling
+pub const CAPDU_EVENT: u16 = 0x0005;
+/// Transmission of a response
+pub const APDU_SEND: u16 = 0x0006;
+/// Cryptographic syscall, the argument being the syscall id
+pub const CX_CALL: u16 = 0x0007;
+/// First id available for application markers
+pub const USER: u16 = 0x0100;
+
+const HEX: &[u8; 16] = b"0123456789abcdef";
+
+/// Returns the number of ticks elapsed since the start of the execution, if
+/// supported.
+fn elapsed() -> Option<u64> {
+    let mut ticks = [0u32; 2];
+    let res: i32;
+    // SYS_ELAPSED: writes the tick count, least significant word first
+    unsafe {
+        asm!(
+            "svc #0xab",
+            in("r1") ticks.as_mut_ptr(),
+            inout("r0") 0x30 => res,
+        );
+    }
+    match res {
+        0 => Some((ticks[1] as u64) << 32 | ticks[0] as u64),
+        _ => None,
+    }
+}
+
+fn emit(kind: u8, id: u16, arg: u32) {
+    let ticks = elapsed();
+    let mut record = *b"@P B 0000 00000000 0000000000000000\n\0";
+    record[3] = kind;
+    for i in 0..4 {
+        record[5 + i] = HEX[(id >> (12 - 4 * i) & 0xf) as usize];
+    }
+    for i in 0..8 {
+        record[10 + i] = HEX[(arg >> (28 - 4 * i) & 0xf) as usize];
+    }
+    match ticks {
+        Some(ticks) => {
+            for i in 0..16 {
+                record[19 + i] = HEX[(ticks >> (60 - 4 * i) & 0xf) as usize];
+            }
+        }
+        None => record[18..20].copy_from_slice(b"\n\0"),
+    }
+    // SYS_WRITE0: prints a null-terminated string
+    unsafe {
+        asm!(
+            "svc #0xab",
+            in("r1") record.as_ptr(),
+            inout("r0") 4 => _,
+        );
+    }
+}
+
+/// Records the beginning of the section `id`.
+pub fn begin(id: u16, arg: u32) {
+    emit(b'B', id, arg);
+}
+
+/// Records the end of the section `id`.
+pub fn end(id: u16, arg: u32) {
+    emit(b'E', id, arg);
+}
+
+/// Profiled section, which ends when dropped.
+pub struct Scope {
+    id: u16,
+    arg: u32,
+}
+
+impl Drop for Scope {
+    fn drop(&mut self) {
+        end(self.id, self.arg);
+    }
+}
+
+/// Records the beginning of the section `id`, and returns a guard which
+/// records its end when dropped.
+pub fn scope(id: u16, arg: u32) -> Scope {
+    begin(id, arg);
+    Scope { id, arg }
+}
+
+/// Called by `syscalls.c` around each cryptographic syscall.
+#[no_mangle]
+extern "C" fn profiling_cx_call(syscall_id: cty::c_uint, begin: cty::c_uint) {
+    emit(if begin != 0 { b'B' } else { b'E' }, CX_CALL, syscall_id);
+}
@@ -80,3 +80,30 @@ impl Random for u32 {
         u32::from_be_bytes(r)
     }
 }
+
+// On host builds, `cx_rng_no_throw` is the deterministic generator of `mock`
+#[cfg(test)]
+mod tests {
+    use super::*;
+    #[cfg(not(feature = "host"))]
+    use crate::assert_eq_err as assert_eq;
+    #[cfg(not(feature = "host"))]
+    use crate::TestType;
+    #[cfg(not(feature = "host"))]
+    use testmacro::test_item as test;
+
+    #[test]
+    fn random_from_range() {
+        let mut seen = [false; 6];
+        for _ in 0..200 {
+            let r = u8::random_from_range(1..7);
+            assert_eq!((1..7).contains(&r), true);
+            seen[r as usize - 1] = true;
+        }
+        assert_eq!(seen, [true; 6]);
+        for _ in 0..200 {
+            let r = u32::random_from_range(1000..1016);
+            assert_eq!((1000..1016).contains(&r), true);
+        }
+    }
+}
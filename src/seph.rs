@@ -1,8 +1,16 @@
 #![allow(clippy::upper_case_acronyms)]
 
 use crate::bindings::*;
+use crate::io::StatusWords;
 use crate::usbbindings::*;
 
+/// Size of the buffers receiving seproxyhal packets
+pub const SEPH_BUFFER_SIZE: usize = 128;
+
+/// Maximum length of a command received over the raw seproxyhal channel
+/// (CAPDU event), which comes in a single packet
+pub const RAW_APDU_MAX_LEN: usize = SEPH_BUFFER_SIZE - 3;
+
 #[repr(u8)]
 pub enum SephTags {
     ScreenDisplayStatus = SEPROXYHAL_TAG_SCREEN_DISPLAY_STATUS as u8,
@@ -84,6 +92,8 @@ pub fn seph_send(buffer: &[u8]) {
 /// Wrapper for 'io_seph_recv'
 /// Receive the next APDU into 'buffer'
 pub fn seph_recv(buffer: &mut [u8], flags: u32) -> u16 {
+    #[cfg(feature = "profiling")]
+    let _scope = crate::profiling::scope(crate::profiling::SEPH_RECV, 0);
     unsafe { io_seph_recv(buffer.as_mut_ptr(), buffer.len() as u16, flags) }
 }
 
@@ -153,6 +163,8 @@ extern "C" {
 /// Below is a straightforward translation of the corresponding functions
 /// in the C SDK, they could be improved
 pub fn handle_usb_event(event: u8) {
+    #[cfg(feature = "profiling")]
+    let _scope = crate::profiling::scope(crate::profiling::USB_EVENT, event as u32);
     match Events::from(event) {
         Events::USBEventReset => {
             unsafe {
@@ -181,6 +193,8 @@ pub fn handle_usb_event(event: u8) {
 }
 
 pub fn handle_usb_ep_xfer_event(apdu_buffer: &mut [u8], buffer: &[u8]) {
+    #[cfg(feature = "profiling")]
+    let _scope = crate::profiling::scope(crate::profiling::USB_XFER_EVENT, buffer[4] as u32);
     let endpoint = buffer[3] & 0x7f;
     match UsbEp::from(buffer[4]) {
         UsbEp::USBEpXFERSetup => unsafe {
@@ -198,9 +212,11 @@ pub fn handle_usb_ep_xfer_event(apdu_buffer: &mut [u8], buffer: &[u8]) {
             if (endpoint as u32) < IO_USB_MAX_ENDPOINTS {
                 unsafe {
                     G_io_app.usb_ep_xfer_len[endpoint as usize] = buffer[5];
+                    // Segments are reassembled directly into the caller buffer,
+                    // whatever its size.
                     let mut apdu_buf = ApduBufferT {
                         buf: apdu_buffer.as_mut_ptr(),
-                        len: 260,
+                        len: apdu_buffer.len().min(u16::MAX as usize) as u16,
                     };
                     USBD_LL_DataOutStage(&mut USBD_Device, endpoint, &buffer[6], &mut apdu_buf);
                 }
@@ -210,7 +226,16 @@ pub fn handle_usb_ep_xfer_event(apdu_buffer: &mut [u8], buffer: &[u8]) {
     }
 }
 
-pub fn handle_capdu_event(apdu_buffer: &mut [u8], buffer: &[u8]) {
+/// Copies the command of a CAPDU event into `apdu_buffer`.
+///
+/// The command comes in a single seproxyhal packet, so it is limited to
+/// [`RAW_APDU_MAX_LEN`] bytes whatever the size of `apdu_buffer` (and to
+/// the size of `apdu_buffer` minus 3 if it is smaller). A larger
+/// command is not truncated but rejected: `BadLen` is returned, to be sent as
+/// the response over the raw channel.
+pub fn handle_capdu_event(apdu_buffer: &mut [u8], buffer: &[u8]) -> Result<(), StatusWords> {
+    #[cfg(feature = "profiling")]
+    let _scope = crate::profiling::scope(crate::profiling::CAPDU_EVENT, 0);
     let mut io_app = unsafe { &mut G_io_app };
     if io_app.apdu_state == APDU_IDLE {
         let max = (apdu_buffer.len() - 3).min(buffer.len() - 3);
@@ -219,12 +244,16 @@ pub fn handle_capdu_event(apdu_buffer: &mut [u8], buffer: &[u8]) {
         io_app.apdu_media = IO_APDU_MEDIA_RAW;
         io_app.apdu_state = APDU_RAW;
 
-        let len = size.min(max);
+        if size > max {
+            io_app.apdu_length = 0;
+            return Err(StatusWords::BadLen);
+        }
 
-        io_app.apdu_length = len as u16;
+        io_app.apdu_length = size as u16;
 
-        apdu_buffer[..len].copy_from_slice(&buffer[3..len + 3]);
+        apdu_buffer[..size].copy_from_slice(&buffer[3..size + 3]);
     }
+    Ok(())
 }
 
 pub fn handle_event(mut apdu_buffer: &mut [u8], spi_buffer: &[u8]) {
@@ -240,7 +269,11 @@ pub fn handle_event(mut apdu_buffer: &mut [u8], spi_buffer: &[u8]) {
                 handle_usb_ep_xfer_event(&mut apdu_buffer, spi_buffer);
             }
         }
-        Events::CAPDUEvent => handle_capdu_event(&mut apdu_buffer, spi_buffer),
+        // An oversized command cannot be answered here, in the middle of
+        // another exchange: it is dropped instead of being truncated.
+        Events::CAPDUEvent => {
+            let _ = handle_capdu_event(&mut apdu_buffer, spi_buffer);
+        }
         Events::TickerEvent => { /* unsafe{ G_io_app.ms += 100; } */ }
         _ => (),
     }
@@ -0,0 +1,458 @@
+//! Retained user interface
+//!
+//! The screen is drawn by the MCU, which receives each element as a
+//! `bagl_component_t` followed by its text in a
+//! `SEPROXYHAL_TAG_SCREEN_DISPLAY_STATUS` message, one SPI round trip per
+//! element. A [`Ui`] keeps the elements of the current screen along with what
+//! was last sent, and [`Ui::redraw`] only sends the elements which changed
+//! since the previous frame:
+//!
+//! ```
+//! let mut ui: Ui<2> = Ui::new();
+//! ui.set(0, Component::label_line(0, 12, 128, 12, FONT_EXTRABOLD_11PX), "Signing");
+//! for i in 0..count {
+//!     ui.set(1, Component::label_line(0, 26, 128, 12, FONT_REGULAR_11PX), progress(i));
+//!     // Only the progress label is sent, in a single packet
+//!     ui.redraw(&mut comm);
+//! }
+//! ```
+//!
+//! Labels and rectangles cover their whole area when drawn, so an element
+//! whose geometry is unchanged is redrawn by itself. When an element moves,
+//! shrinks or is removed, the area it leaves is cleared and the elements it
+//! overlapped are drawn again. Elements are drawn in index order, the last
+//! ones on top.
+
+use crate::bindings::SEPROXYHAL_TAG_SCREEN_DISPLAY_STATUS;
+use crate::io::Comm;
+use crate::seph;
+
+pub const SCREEN_WIDTH: u16 = 128;
+pub const SCREEN_HEIGHT: u16 = 32;
+
+/// Maximum length of the text of an element, longer texts are truncated
+pub const MAX_TEXT_LEN: usize = 32;
+
+pub const BLACK: u32 = 0x000000;
+pub const WHITE: u32 = 0xffffff;
+
+pub const NOFILL: u8 = 0;
+pub const FILL: u8 = 1;
+
+pub const FONT_EXTRABOLD_11PX: u16 = 8;
+pub const FONT_LIGHT_16PX: u16 = 9;
+pub const FONT_REGULAR_11PX: u16 = 10;
+pub const ALIGN_LEFT: u16 = 0x0000;
+pub const ALIGN_RIGHT: u16 = 0x4000;
+pub const ALIGN_CENTER: u16 = 0x8000;
+
+/// Size of `bagl_component_t` on the device
+const COMPONENT_SIZE: usize = 28;
+
+/// `bagl_components_type_e`
+#[derive(Copy, Clone, PartialEq, Eq)]
+#[repr(u8)]
+pub enum ComponentType {
+    None = 0,
+    Button = 1,
+    Label,
+    Rectangle,
+    Line,
+    Icon,
+    Circle,
+    /// Label whose `y` coordinate is the baseline of the text
+    LabelLine,
+}
+
+/// `bagl_component_t`
+#[derive(Copy, Clone, PartialEq, Eq)]
+pub struct Component {
+    pub kind: ComponentType,
+    pub userid: u8,
+    pub x: i16,
+    pub y: i16,
+    pub width: u16,
+    pub height: u16,
+    pub stroke: u8,
+    pub radius: u8,
+    pub fill: u8,
+    pub fgcolor: u32,
+    pub bgcolor: u32,
+    pub font_id: u16,
+    pub icon_id: u8,
+}
+
+impl Component {
+    pub const NONE: Component = Component {
+        kind: ComponentType::None,
+        userid: 0,
+        x: 0,
+        y: 0,
+        width: 0,
+        height: 0,
+        stroke: 0,
+        radius: 0,
+        fill: NOFILL,
+        fgcolor: BLACK,
+        bgcolor: BLACK,
+        font_id: 0,
+        icon_id: 0,
+    };
+
+    /// Filled rectangle
+    pub const fn rect(x: i16, y: i16, width: u16, height: u16, color: u32) -> Self {
+        Component {
+            kind: ComponentType::Rectangle,
+            x,
+            y,
+            width,
+            height,
+            fill: FILL,
+            fgcolor: color,
+            bgcolor: color,
+            ..Self::NONE
+        }
+    }
+
+    /// Centered white text on a black background, `y` being its baseline
+    pub const fn label_line(x: i16, y: i16, width: u16, height: u16, font_id: u16) -> Self {
+        Component {
+            kind: ComponentType::LabelLine,
+            x,
+            y,
+            width,
+            height,
+            fgcolor: WHITE,
+            bgcolor: BLACK,
+            font_id: font_id | ALIGN_CENTER,
+            ..Self::NONE
+        }
+    }
+
+    /// Glyph `icon_id` of the symbols font
+    pub const fn icon(x: i16, y: i16, width: u16, height: u16, icon_id: u8) -> Self {
+        Component {
+            kind: ComponentType::Icon,
+            x,
+            y,
+            width,
+            height,
+            fgcolor: WHITE,
+            bgcolor: BLACK,
+            icon_id,
+            ..Self::NONE
+        }
+    }
+
+    /// Area covered on the screen when drawn. The text of a `LabelLine` is
+    /// drawn above its baseline, the area includes `height` pixels on both
+    /// sides so that descenders are covered.
+    fn area(&self) -> Option<Area> {
+        match self.kind {
+            ComponentType::None => None,
+            ComponentType::LabelLine => Some(Area {
+                x: self.x,
+                y: self.y.saturating_sub(self.height as i16),
+                width: self.width,
+                height: self.height.saturating_mul(2),
+            }),
+            _ => Some(Area {
+                x: self.x,
+                y: self.y,
+                width: self.width,
+                height: self.height,
+            }),
+        }
+    }
+
+    /// Layout of `bagl_component_t` on the device: little endian, the type
+    /// being a single byte as the C SDK is built with `-fshort-enums`.
+    fn to_bytes(self) -> [u8; COMPONENT_SIZE] {
+        let mut b = [0u8; COMPONENT_SIZE];
+        b[0] = self.kind as u8;
+        b[1] = self.userid;
+        b[2..4].copy_from_slice(&self.x.to_le_bytes());
+        b[4..6].copy_from_slice(&self.y.to_le_bytes());
+        b[6..8].copy_from_slice(&self.width.to_le_bytes());
+        b[8..10].copy_from_slice(&self.height.to_le_bytes());
+        b[10] = self.stroke;
+        b[11] = self.radius;
+        b[12] = self.fill;
+        b[16..20].copy_from_slice(&self.fgcolor.to_le_bytes());
+        b[20..24].copy_from_slice(&self.bgcolor.to_le_bytes());
+        b[24..26].copy_from_slice(&self.font_id.to_le_bytes());
+        b[26] = self.icon_id;
+        b
+    }
+}
+
+#[derive(Copy, Clone, PartialEq, Eq)]
+struct Area {
+    x: i16,
+    y: i16,
+    width: u16,
+    height: u16,
+}
+
+impl Area {
+    fn intersects(&self, other: &Area) -> bool {
+        let (x0, y0) = (self.x as i32, self.y as i32);
+        let (x1, y1) = (other.x as i32, other.y as i32);
+        x0 < x1 + other.width as i32
+            && x1 < x0 + self.width as i32
+            && y0 < y1 + other.height as i32
+            && y1 < y0 + self.height as i32
+    }
+}
+
+#[derive(Copy, Clone)]
+struct Element {
+    component: Component,
+    text: [u8; MAX_TEXT_LEN],
+    text_len: u8,
+}
+
+impl Element {
+    const NONE: Element = Element {
+        component: Component::NONE,
+        text: [0u8; MAX_TEXT_LEN],
+        text_len: 0,
+    };
+
+    fn text(&self) -> &[u8] {
+        &self.text[..self.text_len as usize]
+    }
+}
+
+/// Screen made of up to `N` elements, redrawn incrementally.
+pub struct Ui<const N: usize> {
+    elements: [Element; N],
+    /// Area of each element as last sent to the MCU
+    drawn: [Option<Area>; N],
+    dirty: [bool; N],
+    cleared: bool,
+}
+
+impl<const N: usize> Default for Ui<N> {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl<const N: usize> Ui<N> {
+    /// Empty screen. The first redraw clears the whole screen.
+    pub const fn new() -> Self {
+        Ui {
+            elements: [Element::NONE; N],
+            drawn: [None; N],
+            dirty: [false; N],
+            cleared: false,
+        }
+    }
+
+    /// Sets the element at `index`, which is redrawn only if it differs from
+    /// its previous value.
+    pub fn set(&mut self, index: usize, component: Component, text: &str) {
+        self.set_component(index, component);
+        self.set_text(index, text);
+    }
+
+    /// Sets the component of the element at `index`, keeping its text.
+    pub fn set_component(&mut self, index: usize, component: Component) {
+        let element = &mut self.elements[index];
+        if element.component != component {
+            element.component = component;
+            self.dirty[index] = true;
+        }
+    }
+
+    /// Sets the text of the element at `index`, keeping its component.
+    pub fn set_text(&mut self, index: usize, text: &str) {
+        let text = &text.as_bytes()[..text.len().min(MAX_TEXT_LEN)];
+        let element = &mut self.elements[index];
+        if element.text() != text {
+            element.text[..text.len()].copy_from_slice(text);
+            element.text_len = text.len() as u8;
+            self.dirty[index] = true;
+        }
+    }
+
+    /// Removes the element at `index`, its area being cleared on the next
+    /// redraw.
+    pub fn remove(&mut self, index: usize) {
+        self.set(index, Component::NONE, "");
+    }
+
+    /// Forces the next redraw to clear the screen and send every element, for
+    /// instance after something else was displayed.
+    pub fn invalidate(&mut self) {
+        self.cleared = false;
+    }
+
+    /// Sends the elements which changed since the last redraw.
+    ///
+    /// The MCU processes one display message per event, so this waits for it
+    /// between elements. Events received meanwhile are handled like in
+    /// [`Comm::next_event`], except button presses which are discarded. A
+    /// command received meanwhile is returned by the next call to
+    /// `next_event`.
+    pub fn redraw<const M: usize>(&mut self, comm: &mut Comm<M>) {
+        self.plan(|component, text| display(comm, component, text));
+    }
+
+    /// Calls `emit` for each component to draw, in order.
+    fn plan<F: FnMut(&Component, &[u8])>(&mut self, mut emit: F) {
+        if !self.cleared {
+            emit(
+                &Component::rect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BLACK),
+                &[],
+            );
+            self.drawn = [None; N];
+            self.dirty = [true; N];
+            self.cleared = true;
+        }
+
+        // Clear the areas left by the elements which moved, were resized or
+        // removed, and draw again those they overlapped
+        for i in 0..N {
+            let old = match self.drawn[i] {
+                Some(old) if self.dirty[i] => old,
+                _ => continue,
+            };
+            if self.elements[i].component.area() == Some(old) {
+                continue;
+            }
+            emit(
+                &Component::rect(old.x, old.y, old.width, old.height, BLACK),
+                &[],
+            );
+            self.drawn[i] = None;
+            for j in 0..N {
+                if let Some(area) = self.elements[j].component.area() {
+                    if area.intersects(&old) {
+                        self.dirty[j] = true;
+                    }
+                }
+            }
+        }
+
+        for i in 0..N {
+            if !self.dirty[i] {
+                continue;
+            }
+            self.dirty[i] = false;
+            let element = &self.elements[i];
+            self.drawn[i] = element.component.area();
+            let area = match self.drawn[i] {
+                Some(area) => area,
+                None => continue,
+            };
+            emit(&element.component, element.text());
+            // Elements on top of this one are drawn again
+            for j in i + 1..N {
+                if let Some(above) = self.elements[j].component.area() {
+                    if above.intersects(&area) {
+                        self.dirty[j] = true;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// Same as `io_seproxyhal_display_default` for the Nano S, waiting for the
+/// previous display message to be processed.
+fn display<const M: usize>(comm: &mut Comm<M>, component: &Component, text: &[u8]) {
+    let mut spi_buffer = [0u8; seph::SEPH_BUFFER_SIZE];
+    while seph::is_status_sent() {
+        seph::seph_recv(&mut spi_buffer, 0);
+        comm.handle_event(&spi_buffer);
+    }
+    let len = (COMPONENT_SIZE + text.len()) as u16;
+    let [len_hi, len_lo] = len.to_be_bytes();
+    seph::seph_send(&[SEPROXYHAL_TAG_SCREEN_DISPLAY_STATUS as u8, len_hi, len_lo]);
+    seph::seph_send(&component.to_bytes());
+    if !text.is_empty() {
+        seph::seph_send(text);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    #[cfg(not(feature = "host"))]
+    use crate::assert_eq_err as assert_eq;
+    #[cfg(not(feature = "host"))]
+    use crate::TestType;
+    #[cfg(not(feature = "host"))]
+    use testmacro::test_item as test;
+
+    /// Type and abscissa of the components emitted by a redraw
+    fn redraw<const N: usize>(ui: &mut Ui<N>) -> ([(u8, i16); 8], usize) {
+        let mut sent = [(0u8, 0i16); 8];
+        let mut count = 0;
+        ui.plan(|component, _| {
+            sent[count] = (component.kind as u8, component.x);
+            count += 1;
+        });
+        (sent, count)
+    }
+
+    const RECT: u8 = ComponentType::Rectangle as u8;
+    const LABEL: u8 = ComponentType::LabelLine as u8;
+    const ICON: u8 = ComponentType::Icon as u8;
+
+    #[test]
+    fn redraw_changes_only() {
+        let mut ui: Ui<3> = Ui::new();
+        ui.set(
+            0,
+            Component::label_line(0, 12, 128, 12, FONT_EXTRABOLD_11PX),
+            "Signing",
+        );
+        ui.set(
+            1,
+            Component::label_line(0, 28, 64, 12, FONT_REGULAR_11PX),
+            "0%",
+        );
+        ui.set(2, Component::icon(100, 20, 8, 8, 1), "");
+        let (sent, count) = redraw(&mut ui);
+        assert_eq!(count, 4);
+        assert_eq!(sent[0], (RECT, 0));
+
+        ui.set_text(1, "0%");
+        assert_eq!(redraw(&mut ui).1, 0);
+
+        // A single packet for the changed label
+        ui.set_text(1, "10%");
+        let (sent, count) = redraw(&mut ui);
+        assert_eq!(count, 1);
+        assert_eq!(sent[0], (LABEL, 0));
+
+        ui.invalidate();
+        assert_eq!(redraw(&mut ui).1, 4);
+    }
+
+    #[test]
+    fn redraw_moved_and_removed() {
+        let mut ui: Ui<3> = Ui::new();
+        ui.set(0, Component::rect(0, 0, 128, 32, BLACK), "");
+        ui.set(1, Component::icon(10, 10, 8, 8, 1), "");
+        ui.set(2, Component::icon(50, 10, 8, 8, 2), "");
+        redraw(&mut ui);
+
+        // Old area cleared, then the background below and the icons on top
+        ui.set_component(1, Component::icon(20, 10, 8, 8, 1));
+        let (sent, count) = redraw(&mut ui);
+        assert_eq!(count, 4);
+        assert_eq!(sent[0], (RECT, 10));
+        assert_eq!(sent[1], (RECT, 0));
+        assert_eq!(sent[2], (ICON, 20));
+
+        ui.remove(2);
+        let (sent, count) = redraw(&mut ui);
+        assert_eq!(count, 3);
+        assert_eq!(sent[0], (RECT, 50));
+        assert_eq!(redraw(&mut ui).1, 0);
+    }
+}
@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+"""
+APDU round-trip benchmark, driving the `apdu_bench` example application
+running on Speculos.
+
+Each workload (echo, hash, sign) is measured across payload sizes, from short
+APDUs to extended ones, and the p50/p99 round-trip latencies are reported. The
+results can be saved as JSON and compared to a baseline, the script exiting
+with an error if a latency regressed by more than the given tolerance, unless
+regressions are only reported.
+
+    cargo build --release --example apdu_bench
+    ./tools/apdu_bench.py --launch target/thumbv6m-none-eabi/release/examples/apdu_bench
+
+Speculos' APDU port delivers commands through its emulated USB HID
+transport, in 64-byte HID packets, so extended APDUs are supported. The
+transport actually used is queried from the application and reported with the
+results. On the raw seproxyhal channel (CAPDU events), commands are limited to
+the size of a seproxyhal packet: larger sizes are then skipped.
+"""
+
+import argparse
+import json
+import socket
+import statistics
+import subprocess
+import sys
+import time
+
+CLA = 0xE0
+WORKLOADS = {"echo": 0x01, "hash": 0x02, "sign": 0x03}
+INS_INFO = 0x04
+SIZES = [5, 32, 64, 128, 255, 512, 1000]
+MEDIA = {1: "usb_hid", 2: "ble", 3: "nfc", 4: "usb_ccid", 5: "webusb", 6: "raw"}
+# Longest command on the raw seproxyhal channel (seph::RAW_APDU_MAX_LEN)
+RAW_APDU_MAX_LEN = 125
+
+
+class Speculos:
+    """Client of the APDU TCP port of Speculos."""
+
+    def __init__(self, host, port, timeout):
+        deadline = time.monotonic() + timeout
+        while True:
+            try:
+                self.sock = socket.create_connection((host, port))
+                break
+            except OSError:
+                if time.monotonic() > deadline:
+                    raise
+                time.sleep(0.1)
+
+    def _recv(self, size):
+        data = b""
+        while len(data) < size:
+            chunk = self.sock.recv(size - len(data))
+            if not chunk:
+                raise ConnectionError("connection closed by Speculos")
+            data += chunk
+        return data
+
+    def exchange(self, apdu):
+        self.sock.sendall(len(apdu).to_bytes(4, "big") + apdu)
+        size = int.from_bytes(self._recv(4), "big")
+        response = self._recv(size + 2)
+        return response[:-2], int.from_bytes(response[-2:], "big")
+
+    def close(self):
+        self.sock.close()
+
+
+def make_apdu(ins, data):
+    if len(data) <= 255:
+        return bytes([CLA, ins, 0, 0, len(data)]) + data
+    return bytes([CLA, ins, 0, 0, 0]) + len(data).to_bytes(2, "big") + data
+
+
+def percentile(samples, p):
+    samples = sorted(samples)
+    index = min(len(samples) - 1, int(round(p / 100 * (len(samples) - 1))))
+    return samples[index]
+
+
+def run(client, iterations, warmup, sizes):
+    data, sw = client.exchange(make_apdu(INS_INFO, b""))
+    if sw != 0x9000:
+        raise RuntimeError("info command failed with 0x%04x" % sw)
+    transport = MEDIA.get(data[0], str(data[0]))
+    # The command, then the response and its status word, must fit in the
+    # APDU buffer
+    max_len = int.from_bytes(data[1:3], "big") - 2
+    if transport == "raw":
+        max_len = min(max_len, RAW_APDU_MAX_LEN)
+    results = {"transport": transport, "workloads": {}}
+    for name, ins in WORKLOADS.items():
+        for size in sizes:
+            apdu = make_apdu(ins, bytes(i & 0xFF for i in range(size)))
+            if len(apdu) > max_len:
+                print("skipping %s/%d: too long for %s" % (name, size, transport), file=sys.stderr)
+                continue
+            samples = []
+            for i in range(warmup + iterations):
+                start = time.perf_counter()
+                _, sw = client.exchange(apdu)
+                elapsed = time.perf_counter() - start
+                if sw != 0x9000:
+                    raise RuntimeError("%s(%d) failed with 0x%04x" % (name, size, sw))
+                if i >= warmup:
+                    samples.append(elapsed * 1e6)
+            results["workloads"]["%s/%d" % (name, size)] = {
+                "p50_us": percentile(samples, 50),
+                "p99_us": percentile(samples, 99),
+                "mean_us": statistics.mean(samples),
+                "apdus_per_s": 1e6 / statistics.mean(samples),
+            }
+    return results
+
+
+def compare(results, baseline, tolerance):
+    regressions = []
+    for key, current in results["workloads"].items():
+        previous = baseline["workloads"].get(key)
+        if previous is None:
+            continue
+        for metric in ("p50_us", "p99_us"):
+            if current[metric] > previous[metric] * (1 + tolerance):
+                regressions.append(
+                    "%s %s: %.0f us -> %.0f us"
+                    % (key, metric, previous[metric], current[metric])
+                )
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().split("\n")[0])
+    parser.add_argument("--launch", metavar="ELF", help="start Speculos with this application")
+    parser.add_argument("--speculos", default="speculos.py", help="Speculos command")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=9999, help="Speculos APDU port")
+    parser.add_argument("--iterations", type=int, default=200)
+    parser.add_argument("--warmup", type=int, default=10)
+    parser.add_argument("--sizes", type=lambda s: [int(x) for x in s.split(",")], default=SIZES)
+    parser.add_argument("--output", metavar="JSON", help="save the results")
+    parser.add_argument("--baseline", metavar="JSON", help="compare to previous results")
+    parser.add_argument("--tolerance", type=float, default=0.2,
+                        help="allowed latency increase over the baseline (default: 0.2)")
+    parser.add_argument("--report-only", action="store_true",
+                        help="report regressions without failing")
+    args = parser.parse_args()
+
+    speculos = None
+    if args.launch:
+        speculos = subprocess.Popen(
+            [args.speculos, "--display", "headless", "--apdu-port", str(args.port), args.launch],
+            stdout=subprocess.DEVNULL,
+            stderr=subprocess.DEVNULL,
+        )
+    try:
+        client = Speculos(args.host, args.port, timeout=30)
+        results = run(client, args.iterations, args.warmup, args.sizes)
+        client.close()
+    finally:
+        if speculos:
+            speculos.terminate()
+            speculos.wait()
+
+    print("transport: %s" % results["transport"])
+    print("%-12s %10s %10s %10s" % ("workload", "p50 (us)", "p99 (us)", "APDU/s"))
+    for key, r in results["workloads"].items():
+        print("%-12s %10.0f %10.0f %10.1f" % (key, r["p50_us"], r["p99_us"], r["apdus_per_s"]))
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(results, f, indent=2)
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            regressions = compare(results, json.load(f), args.tolerance)
+        if regressions:
+            print("\nregressions:")
+            for r in regressions:
+                print("  " + r)
+            if not args.report_only:
+                sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""
+Records the profiling markers of an application built with the `profiling`
+feature and running on Speculos, and converts them for visualization.
+
+Record, launching Speculos (or reading its output from stdin with `-`), then
+send APDUs to the application and stop with Ctrl-C:
+
+    ./tools/profile_trace.py record --launch app.elf -o app.prof
+
+Convert to trace-event JSON (chrome://tracing, Perfetto) or to folded stacks
+(flamegraph.pl, inferno, speedscope):
+
+    ./tools/profile_trace.py convert app.prof --format trace -o app.json
+    ./tools/profile_trace.py convert app.prof --format folded | flamegraph.pl > app.svg
+
+Records are timestamped by the application when emitted, with the tick count
+of the emulator (nanoseconds for Speculos, see --tick-freq). If the records
+have no timestamp, they are timestamped when read from the output of Speculos
+instead, which adds the latency of the pipe. Either way, timings are those of
+the emulated execution and are only meaningful relative to each other.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import time
+from collections import defaultdict
+
+RECORD = re.compile(r"@P ([BE]) ([0-9a-f]{4}) ([0-9a-f]{8})(?: ([0-9a-f]{16}))?")
+
+NAMES = {
+    0x0001: "next_event",
+    0x0002: "seph_recv",
+    0x0003: "usb_event",
+    0x0004: "usb_xfer_event",
+    0x0005: "capdu_event",
+    0x0006: "apdu_send",
+    0x0007: "cx_call",
+}
+CX_CALL = 0x0007
+
+
+def marker_name(marker, arg):
+    if marker == CX_CALL:
+        return "cx_call(0x%08x)" % arg
+    return NAMES.get(marker, "marker_0x%04x" % marker)
+
+
+def record(args):
+    if args.launch:
+        env = dict(os.environ, PYTHONUNBUFFERED="1")
+        proc = subprocess.Popen(
+            [args.speculos, "--display", "headless", args.launch] + args.speculos_args,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.STDOUT,
+            env=env,
+            universal_newlines=True,
+        )
+        stream = proc.stdout
+    else:
+        proc = None
+        stream = sys.stdin
+    out = open(args.output, "w") if args.output else sys.stdout
+    count = 0
+    host_count = 0
+    try:
+        # readline() does not read ahead, so each line without a timestamp is
+        # timestamped as soon as it is emitted
+        for line in iter(stream.readline, ""):
+            now = time.perf_counter_ns()
+            m = RECORD.search(line)
+            if m:
+                if m.group(4):
+                    ts = int(m.group(4), 16) * 1000000000 // args.tick_freq
+                else:
+                    ts = now
+                    host_count += 1
+                out.write("%d %s %s %s\n" % (ts, m.group(1), m.group(2), m.group(3)))
+                count += 1
+            elif args.verbose:
+                sys.stderr.write(line)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if proc:
+            proc.terminate()
+            proc.wait()
+        if out is not sys.stdout:
+            out.close()
+    sys.stderr.write("%d records\n" % count)
+    if host_count:
+        sys.stderr.write("%d records timestamped on the host\n" % host_count)
+
+
+def read_records(path):
+    with open(path) as f:
+        for line in f:
+            ts, kind, marker, arg = line.split()
+            yield int(ts), kind, int(marker, 16), int(arg, 16)
+
+
+def to_trace(records):
+    events = []
+    start = None
+    for ts, kind, marker, arg in records:
+        if start is None:
+            start = ts
+        events.append({
+            "name": marker_name(marker, arg),
+            "ph": kind,
+            "ts": (ts - start) / 1000,
+            "pid": 1,
+            "tid": 1,
+        })
+    return json.dumps({"traceEvents": events, "displayTimeUnit": "ns"})
+
+
+def to_folded(records):
+    """Self time of each stack, in microseconds."""
+    totals = defaultdict(int)
+    stack = []
+    last = None
+    for ts, kind, marker, arg in records:
+        if stack and last is not None:
+            totals[";".join(stack)] += ts - last
+        last = ts
+        name = marker_name(marker, arg)
+        if kind == "B":
+            stack.append(name)
+        elif stack and stack[-1] == name:
+            stack.pop()
+        else:
+            # Unbalanced record, for instance at the start of the recording
+            stack = []
+    return "".join("%s %d\n" % (s, ns // 1000) for s, ns in totals.items() if ns >= 1000)
+
+
+def convert(args):
+    records = list(read_records(args.input))
+    if args.format == "trace":
+        result = to_trace(records)
+    else:
+        result = to_folded(records)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(result)
+    else:
+        sys.stdout.write(result)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().split("\n")[0])
+    sub = parser.add_subparsers(dest="command")
+    sub.required = True
+
+    rec = sub.add_parser("record", help="record the markers emitted on Speculos")
+    rec.add_argument("--launch", metavar="ELF", help="start Speculos with this application")
+    rec.add_argument("--speculos", default="speculos.py", help="Speculos command")
+    rec.add_argument("--speculos-args", nargs=argparse.REMAINDER, default=[],
+                     help="additional arguments passed to Speculos")
+    rec.add_argument("--tick-freq", type=int, default=1000000000,
+                     help="frequency of the tick count of the records, in Hz (default: 1e9)")
+    rec.add_argument("-o", "--output", help="recording file (default: stdout)")
+    rec.add_argument("-v", "--verbose", action="store_true", help="print the other output of Speculos")
+    rec.set_defaults(func=record)
+
+    conv = sub.add_parser("convert", help="convert a recording")
+    conv.add_argument("input", help="recording file")
+    conv.add_argument("--format", choices=("trace", "folded"), default="trace")
+    conv.add_argument("-o", "--output", help="output file (default: stdout)")
+    conv.set_defaults(func=convert)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()